@@ -4,15 +4,48 @@
 #include "gfc_vector.h"
 #include "gfc_shape.h"
 
-typedef struct {
+struct Space_S;
+struct Entity_S;
+struct CharacterController_S;
+
+typedef enum {
+	BL_NONE		= 0,
+	BL_WORLD	= 1 << 0,	//<Static world geometry such as tiles
+	BL_PLAYER	= 1 << 1,	//<The player
+	BL_ENEMY	= 1 << 2,	//<Enemies and other hostile bodies
+	BL_PROJECTILE	= 1 << 3,	//<Bullets and other projectiles
+	BL_PROP		= 1 << 4	//<Crates and other pushable props
+}BodyLayer;
+
+#define BL_ALL	0xFFFFFFFF	//<Every layer
+
+typedef struct Body_S {
 	// Physics quantities
 	GFC_Vector2D	position; 		//<the body's position in space
 	GFC_Vector2D	velocity; 		//<the body's velocity in space
 	GFC_Vector2D	acceleration;		//<the body's acceleration modified by the entity object and cleared at the end of the frame
 	GFC_Vector2D	net_acceleration;	//<the body's total acceleration actually used for calculation
+	float		inv_mass;		//<one over the body's mass, 0 for a body that cannot be pushed
 	
 	// Collision config
-	GFC_Shape	collider;		//<the body's collider
+	Uint32		id;			//<the body's id in its space, used to key cached contacts
+	GFC_Shape	collider;		//<the body's collider, relative to the body's position
+	Uint32		layer;			//<the layers the body belongs to
+	Uint32		mask;			//<the layers the body collides with
+	struct Body_S	*owner;			//<(optional) a body this body never collides with, such as a projectile's shooter
+	struct Space_S	*space;			//<the space the body was added to, NULL if none
+	struct Entity_S	*entity;		//<(optional) the entity this body belongs to
+	struct CharacterController_S *controller;//<(optional) moves the body through the tile grid instead of the integrator, owned by the body
+
+	// Substepping
+	Uint32		substeps;		//<how many steps the body is split into during the current space update
+
+	// Joint solver scratch
+	Uint64		joint_colors;		//<the joint colors already used on this body, only valid while joints are being colored
+
+	// Sleep state
+	Uint8		sleeping;		//<whether the body is at rest and skipped by the simulation
+	Uint32		rest_steps;		//<how many consecutive steps the body has spent below the sleep threshold
 }Body;
 
 /**
@@ -22,9 +55,50 @@ typedef struct {
 Body *body_new();
 
 /**
- * @brief free a physics body object
+ * @brief free a physics body object, removing it from its space first
  * @param self the body object to be freed
  */
 void body_free(Body *self);
 
+/**
+ * @brief check if two bodies are allowed to collide with each other
+ * @param a one of the bodies
+ * @param b the other body
+ * @return 1 if each body's mask includes the other's layer and neither owns the other, 0 otherwise
+ */
+Uint8 body_can_collide(Body *a, Body *b);
+
+/**
+ * @brief get the layer bit that corresponds with a layer name
+ * @param name the name of the layer, such as "world" or "projectile"
+ * @return BL_NONE if the name is unknown, otherwise the layer's bit
+ */
+Uint32 body_layer_from_name(const char *name);
+
+/**
+ * @brief set the mass of a body
+ * @param self the body to be modified
+ * @param mass the new mass, 0 or less makes the body immovable by contacts
+ */
+void body_set_mass(Body *self, float mass);
+
+/**
+ * @brief get a body's collider translated into world space
+ * @param self the body whose collider is being retrieved
+ * @return the body's collider offset by the body's position
+ */
+GFC_Shape body_world_collider(Body *self);
+
+/**
+ * @brief wake a sleeping body so that it is simulated again
+ * @param self the body to be woken
+ */
+void body_wake(Body *self);
+
+/**
+ * @brief put a body to sleep, zeroing its motion so it is skipped by the simulation
+ * @param self the body to be put to sleep
+ */
+void body_sleep(Body *self);
+
 #endif
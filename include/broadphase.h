@@ -0,0 +1,77 @@
+#ifndef __BROADPHASE_H__
+#define __BROADPHASE_H__
+
+#include "gfc_list.h"
+#include "gfc_shape.h"
+
+#include "body.h"
+
+#define BROADPHASE_TILE_GRID	-2	// <Shape index of a pair that tests a body against the space's tile grid
+
+typedef struct {
+	Body		*body;		// <The body this proxy stands in for
+	GFC_Rect	bounds;		// <The body's world space bounding box
+}BroadphaseProxy;
+
+typedef struct {
+	Body		*a;		// <The body being tested
+	Body		*b;		// <The other body being tested, NULL if testing against a static shape
+	Sint32		shape;		// <Index of the static shape being tested, -1 if testing two bodies, BROADPHASE_TILE_GRID for the tile grid
+}CollisionPair;
+
+typedef struct {
+	BroadphaseProxy	*proxies;	// <Body proxies sorted by the left edge of their bounds
+	Uint32		proxy_count;	// <Number of proxies in use
+	Uint32		proxy_capacity;	// <Number of proxies allocated
+	float		max_width;	// <Width of the widest proxy, bounds how far back a query has to look
+
+	CollisionPair	*pairs;		// <Candidate pairs found by the last update
+	Uint32		pair_count;	// <Number of candidate pairs in use
+	Uint32		pair_capacity;	// <Number of candidate pairs allocated
+}Broadphase;
+
+/**
+ * @brief rebuild the body proxies and collect every pair whose bounds overlap
+ * @param self the broadphase to be updated
+ * @param bodies the list of bodies in the space
+ * @param static_shapes the list of static shapes in the space
+ * @param static_layer the collision layer the static shapes belong to
+ * @param grid (optional) the bounds of the space's tile grid, bodies inside it get a pair against the grid
+ * @note pairs are sorted and swept along the x axis, pairs where neither side can move
+ *       and pairs whose layers and masks do not match are skipped before their bounds are tested.
+ *       Immovable bodies are not paired with static shapes, since neither can push the other.
+ */
+void broadphase_update(Broadphase *self, GFC_List *bodies, GFC_List *static_shapes, Uint32 static_layer, const GFC_Rect *grid);
+
+/**
+ * @brief rebuild and sort the body proxies without looking for pairs
+ * @param self the broadphase to be refreshed
+ * @param bodies the list of bodies in the space
+ */
+void broadphase_refresh(Broadphase *self, GFC_List *bodies);
+
+/**
+ * @brief find every body whose bounds overlap a rect, using the proxies from the last update
+ * @param self the broadphase to be searched
+ * @param bounds the world space rect being queried
+ * @param callback called once for each overlapping body
+ * @param data passed through to the callback
+ * @note proxies are sorted, so only bodies near the rect along the x axis are visited
+ */
+void broadphase_query(Broadphase *self, GFC_Rect bounds, void (*callback)(Body *body, void *data), void *data);
+
+/**
+ * @brief drop a body's proxy so later queries cannot return it
+ * @param self the broadphase the body was in
+ * @param body the body being removed from the space
+ * @note the remaining proxies stay sorted, the candidate pairs are left alone since they are rebuilt before use
+ */
+void broadphase_remove_body(Broadphase *self, Body *body);
+
+/**
+ * @brief release the memory held by a broadphase
+ * @param self the broadphase to be freed
+ */
+void broadphase_free(Broadphase *self);
+
+#endif
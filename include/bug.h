@@ -7,8 +7,9 @@
  * @brief spawn a new bug entity
  * @param position where to spawn it
  * @param filename path to def file for creating bug
+ * @param owner (optional) the entity that fired the bug, the bug never collides with it
  * @return NULL on error
  */
-Entity *bug_new_entity(GFC_Vector2D position, const char *filename);
+Entity *bug_new_entity(GFC_Vector2D position, const char *filename, Entity *owner);
 
 #endif
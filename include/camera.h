@@ -9,7 +9,7 @@
 typedef struct Camera_S {
 	// Spatial information
 	GFC_Vector2D	position;	// <The camera's position
-	GFC_Rect	bounds;		// <The camera's bounds in space
+	GFC_Rect	bounds;		// <The area of the world in view, accounting for zoom
 	float		zoom;		// <The camera's zoom factor (scales game objects, not UI)
 
 	// Entity targeting references
@@ -54,6 +54,19 @@ GFC_Vector2D main_camera_get_offset();
  */
 GFC_Vector2D main_camera_calc_drawpos(GFC_Vector2D position);
 
+/**
+ * @brief get the area of the world the main camera can see
+ * @return a world space rect covering the screen at the camera's current position and zoom
+ */
+GFC_Rect main_camera_get_view();
+
+/**
+ * @brief check if a world space rect can be seen by the main camera
+ * @param rect the rect in world space
+ * @return 1 if any part of the rect is on screen, 0 if it can be skipped when drawing
+ */
+Uint8 main_camera_rect_visible(GFC_Rect rect);
+
 // DEPRECATED FUNCTIONS
 
 /**
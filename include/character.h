@@ -0,0 +1,60 @@
+#ifndef __CHARACTER_H__
+#define __CHARACTER_H__
+
+#include "gfc_vector.h"
+
+#include "body.h"
+
+struct Space_S;
+
+#define CHARACTER_SLOPE_LIMIT	45	// <Default steepest surface, in degrees, that still counts as ground
+#define CHARACTER_SKIN		0.05	// <Default gap kept between the collider and the tiles it slides along
+#define CHARACTER_MAX_SLIDES	4	// <Most surfaces a single move can slide along before it gives up
+#define CHARACTER_GROUND_PROBE	2	// <How far below the collider ground is looked for after a move
+
+typedef struct CharacterController_S {
+	// Config
+	float		slope_limit;	// <Steepest surface, in degrees, that counts as ground and can be walked up
+	float		skin;		// <Gap kept between the collider and the tiles it slides along
+
+	// State after the last move
+	Uint8		grounded;	// <Whether the character is standing on something
+	Uint8		on_one_way;	// <Whether the ground is a one way platform
+	GFC_Vector2D	ground_normal;	// <The normal of the ground, (0,0) while airborne
+	Uint32		hit_count;	// <Number of surfaces the last move slid along
+}CharacterController;
+
+/**
+ * @brief allocate memory for a character controller
+ * @return NULL if failed to allocate memory, otherwise a controller with the default config
+ */
+CharacterController *character_new();
+
+/**
+ * @brief free a character controller
+ * @param self the controller to be freed
+ * @note bodies free their own controller, only call this for a controller that was never attached
+ */
+void character_free(CharacterController *self);
+
+/**
+ * @brief attach a controller to a body, the body takes ownership of it
+ * @param body the body to be moved by the controller
+ * @param self the controller
+ * @note the body becomes kinematic: it pushes other bodies but contacts never push it back,
+ *       and the space moves it with character_move instead of integrating its position
+ */
+void character_attach(Body *body, CharacterController *self);
+
+/**
+ * @brief move a body through the space's tile grid, sliding along anything it hits
+ * @param self the body's controller, updated with the ground state after the move
+ * @param space the space whose tile grid the body moves through
+ * @param body the body to be moved, its velocity loses whatever pushes into the surfaces it hit
+ * @param motion how far the body wants to move
+ * @note one way tiles are only solid from above, and surfaces steeper than the slope limit can't be climbed.
+ *       Nothing is allocated, so this is cheap enough to run on every NPC.
+ */
+void character_move(CharacterController *self, struct Space_S *space, Body *body, GFC_Vector2D motion);
+
+#endif
@@ -3,12 +3,63 @@
 
 #include "gfc_list.h"
 #include "gfc_vector.h"
+#include "gfc_shape.h"
+
+#include "body.h"
+
+#define COLLISION_RECT_BATCH	8		// <Number of rects tested against a circle at once
+#define COLLISION_TILE_SHAPE	0x40000000	// <Set in a contact's shape index when the rest of it is a tile grid cell
 
 typedef struct {
 	GFC_Vector2D	poc;	// <The point of collision
 	GFC_Vector2D	normal;	// <The normal vector for the collision
 }Collision;
 
+typedef struct {
+	Body		*a;	// <The body in contact
+	Body		*b;	// <The other body in contact, NULL if the contact is with a static shape
+	Sint32		shape;	// <Index of the static shape in contact, COLLISION_TILE_SHAPE | cell for a tile, -1 between two bodies
+	GFC_Vector2D	poc;	// <The point of contact
+	GFC_Vector2D	normal;	// <The contact normal, pointing towards body a
+	float		depth;	// <How far the shapes are overlapping along the normal
+	float		impulse;// <Accumulated normal impulse, warm started from the contact cache
+}Contact;
+
+typedef struct {
+	Contact		*contacts;	// <The contact array
+	Uint32		count;		// <Number of contacts in use
+	Uint32		capacity;	// <Number of contacts allocated
+}ContactBuffer;
+
+typedef struct {
+	Uint64		key;		// <The key of the contact pair, 0 if the slot is empty
+	float		impulse;	// <Accumulated normal impulse from the last time the pair was solved
+	Uint32		stamp;		// <The cache stamp the entry was last touched in
+}ContactCacheEntry;
+
+typedef struct {
+	ContactCacheEntry	*entries;	// <Open addressed entry table
+	Uint32			capacity;	// <Number of slots in the table, always a power of two
+	Uint32			count;		// <Number of slots in use
+	Uint32			stamp;		// <Current stamp, advanced every prune
+}ContactCache;
+
+typedef struct {
+	float		x[COLLISION_RECT_BATCH];	// <Left edge of each rect
+	float		y[COLLISION_RECT_BATCH];	// <Top edge of each rect
+	float		w[COLLISION_RECT_BATCH];	// <Width of each rect
+	float		h[COLLISION_RECT_BATCH];	// <Height of each rect
+	Uint32		count;				// <Number of rects in use
+}CollisionRectBatch;
+
+typedef struct {
+	float		depth[COLLISION_RECT_BATCH];	// <How far the circle overlaps each rect
+	float		normal_x[COLLISION_RECT_BATCH];	// <Contact normal pointing from the rect towards the circle
+	float		normal_y[COLLISION_RECT_BATCH];
+	float		poc_x[COLLISION_RECT_BATCH];	// <Point of contact on the rect's surface
+	float		poc_y[COLLISION_RECT_BATCH];
+}CollisionRectHits;
+
 /**
  * @brief free a collision list
  * @param the list object to be freed
@@ -26,4 +77,79 @@ Collision *collision_new();
  * @param collision the collision object to be freed
  */
 void collision_free(Collision *collision);
+
+/**
+ * @brief get the axis aligned bounding box of a shape
+ * @param shape the shape to be bounded
+ * @return a rect containing the whole shape
+ */
+GFC_Rect collision_shape_bounds(GFC_Shape shape);
+
+/**
+ * @brief test a circle against a batch of axis aligned rects at once
+ * @param circle the circle in world space
+ * @param rects the rects, in structure of arrays form
+ * @param hits receives the depth, normal and point of contact for every rect that overlaps
+ * @return a bit mask with bit i set if rect i overlaps the circle, only those entries of hits are valid
+ * @note uses SSE when the compiler targets it, with a scalar fallback otherwise.
+ *       A circle whose center is inside a rect is pushed out through the nearest edge.
+ *       The SSE path reads lanes in groups of four, so lanes past count up to the next multiple of four must be filled.
+ */
+Uint32 collision_circle_rect_batch(GFC_Circle circle, const CollisionRectBatch *rects, CollisionRectHits *hits);
+
+/**
+ * @brief get a new contact slot at the end of a contact buffer, growing it if needed
+ * @param buffer the buffer to be appended to
+ * @return NULL if failed to allocate memory, otherwise a blank contact
+ * @note the buffer only grows, so steady state use does not allocate
+ */
+Contact *contact_buffer_push(ContactBuffer *buffer);
+
+/**
+ * @brief append every contact in one buffer to the end of another
+ * @param dst the buffer being appended to
+ * @param src the buffer whose contacts are copied
+ */
+void contact_buffer_append(ContactBuffer *dst, ContactBuffer *src);
+
+/**
+ * @brief empty a contact buffer without releasing its memory
+ * @param buffer the buffer to be cleared
+ */
+void contact_buffer_clear(ContactBuffer *buffer);
+
+/**
+ * @brief release the memory held by a contact buffer
+ * @param buffer the buffer to be freed
+ */
+void contact_buffer_free(ContactBuffer *buffer);
+
+/**
+ * @brief get the cache key of a contact from its body ids and static shape index
+ * @param contact the contact whose key is being built
+ * @return a key that is the same no matter which order the bodies were found in
+ */
+Uint64 contact_key(Contact *contact);
+
+/**
+ * @brief look up a contact pair in the cache
+ * @param cache the cache to be searched
+ * @param key the key of the pair
+ * @param create if nonzero a blank entry is inserted when the pair is missing
+ * @return NULL if the pair is not cached (and was not created), otherwise the pair's entry
+ * @note the returned entry is stamped as used in the current update
+ */
+ContactCacheEntry *contact_cache_get(ContactCache *cache, Uint64 key, Uint8 create);
+
+/**
+ * @brief drop every entry that was not used since the last prune
+ * @param cache the cache to be pruned
+ */
+void contact_cache_prune(ContactCache *cache);
+
+/**
+ * @brief release the memory held by a contact cache
+ * @param cache the cache to be freed
+ */
+void contact_cache_free(ContactCache *cache);
 #endif
@@ -0,0 +1,49 @@
+#ifndef __GF2D_ATLAS_H__
+#define __GF2D_ATLAS_H__
+
+#include <SDL.h>
+#include "gfc_types.h"
+
+#define GF2D_ATLAS_PADDING 1    /**<empty pixels kept around each packed image so filtering does not bleed between them*/
+
+/**
+ * @brief initializes the texture atlas
+ * @note until this is called every sprite keeps its own texture
+ * @param page_size the width and height of each atlas texture
+ * @param max_pages the most atlas textures that will be created
+ * @param max_image_size images wider or taller than this keep their own texture
+ */
+void gf2d_atlas_init(Uint32 page_size,Uint32 max_pages,Uint32 max_image_size);
+
+/**
+ * @brief pack an image into an atlas page and upload its pixels
+ * @param surface the image to pack
+ * @param texture set to the page's texture on success
+ * @param rect set to where the image was placed within the page on success
+ * @param page set to the index of the page on success
+ * @return 1 if the image was packed, 0 if it does not fit and should get its own texture
+ */
+Uint8 gf2d_atlas_add(SDL_Surface *surface,SDL_Texture **texture,SDL_Rect *rect,Uint32 *page);
+
+/**
+ * @brief give back the space of an image packed with gf2d_atlas_add
+ * @note a page is emptied once all its images are removed, before that only an image with
+ *       nothing packed on top of it frees its space, the rest waits for the page to empty
+ * @param page the page the image was packed into
+ * @param rect where the image was placed within the page
+ */
+void gf2d_atlas_remove(Uint32 page,SDL_Rect *rect);
+
+/**
+ * @brief get how many atlas pages have been created
+ * @return the number of pages
+ */
+Uint32 gf2d_atlas_get_page_count();
+
+/**
+ * @brief get the memory held by the atlas pages, counted at four bytes a pixel
+ * @return the bytes of every page created so far
+ */
+Uint64 gf2d_atlas_get_bytes();
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef __GF2D_BATCH_H__
+#define __GF2D_BATCH_H__
+
+#include <SDL.h>
+#include "gfc_types.h"
+
+/**
+ * SDL_RenderGeometry is only available from SDL 2.0.18, older versions draw every quad on its own
+ */
+#define GF2D_BATCH_GEOMETRY SDL_VERSION_ATLEAST(2,0,18)
+
+#define GF2D_BATCH_DEFAULT_QUADS 1024 /**<quads collected if the batch is used before being initialized*/
+
+typedef struct
+{
+    SDL_Texture *texture;   /**<the texture to draw from*/
+    SDL_Rect src;           /**<the pixel rect of the texture to draw*/
+    SDL_FPoint corners[4];  /**<screen position of the top left, top right, bottom right and bottom left corners*/
+    SDL_Color color;        /**<color and alpha to modulate the texture with*/
+    SDL_RendererFlip flip;  /**<which axes to mirror the texture on*/
+}GF2D_Quad;
+
+/**
+ * @brief initializes the sprite batch
+ * @param max_quads how many quads can be collected before the batch is flushed on its own
+ * @note if this is not called the batch initializes itself with GF2D_BATCH_DEFAULT_QUADS on first use
+ */
+void gf2d_batch_init(Uint32 max_quads);
+
+/**
+ * @brief add a textured quad to the batch
+ * @note the batch is flushed first if the texture differs from the quads already collected or the batch is full
+ * @param texture the texture to draw from
+ * @param src the pixel rect of the texture to draw
+ * @param corners the screen position of the quad's top left, top right, bottom right and bottom left corners
+ * @param color the color and alpha to modulate the texture with
+ * @param flip which axes to mirror the texture on
+ */
+void gf2d_batch_quad(
+    SDL_Texture *texture,
+    const SDL_Rect *src,
+    const SDL_FPoint corners[4],
+    SDL_Color color,
+    SDL_RendererFlip flip);
+
+/**
+ * @brief submit every collected quad to the renderer
+ * @note must be called before anything else is drawn with the renderer directly, and before presenting the frame
+ */
+void gf2d_batch_flush();
+
+/**
+ * @brief let the batch know a texture is about to be destroyed
+ * @note flushes any quads still using it, so they are drawn before it goes away
+ * @param texture the texture being destroyed
+ */
+void gf2d_batch_release_texture(SDL_Texture *texture);
+
+/**
+ * @brief get how many draw calls the batch submitted since the last call
+ * @return the number of draw calls
+ */
+Uint32 gf2d_batch_get_draw_calls();
+
+#endif
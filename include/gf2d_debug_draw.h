@@ -0,0 +1,78 @@
+#ifndef __GF2D_DEBUG_DRAW_H__
+#define __GF2D_DEBUG_DRAW_H__
+
+#include <SDL.h>
+#include "gfc_types.h"
+#include "gfc_vector.h"
+#include "gfc_shape.h"
+#include "gfc_color.h"
+
+/**
+ * Debug primitives are collected over the frame, grouped by color, and drawn over everything else
+ * with one SDL call per group and kind of primitive.
+ * Build with GF2D_DEBUG_DRAW defined to 0 to compile every call out.
+ */
+#ifndef GF2D_DEBUG_DRAW
+#define GF2D_DEBUG_DRAW 1
+#endif
+
+#define GF2D_DEBUG_DRAW_COLORS 32   /**<distinct colors per flush, drawing with more flushes early*/
+
+#if GF2D_DEBUG_DRAW
+
+/**
+ * @brief initializes the debug draw buffer
+ * @param max_primitives how many points, line points and rects each color starts with room for, they grow past this if needed
+ */
+void gf2d_debug_draw_init(Uint32 max_primitives);
+
+/**
+ * @brief buffer a single point
+ * @param point the point in screen space
+ * @param color the color to draw it
+ */
+void gf2d_debug_draw_point(GFC_Vector2D point,GFC_Color color);
+
+/**
+ * @brief buffer a line
+ * @note a line starting where the previous line of the same color ended continues its strip
+ * @param p1 the start of the line in screen space
+ * @param p2 the end of the line in screen space
+ * @param color the color to draw it
+ */
+void gf2d_debug_draw_line(GFC_Vector2D p1,GFC_Vector2D p2,GFC_Color color);
+
+/**
+ * @brief buffer a rect outline
+ * @param rect the rect in screen space
+ * @param color the color to draw it
+ */
+void gf2d_debug_draw_rect(GFC_Rect rect,GFC_Color color);
+
+/**
+ * @brief buffer a circle outline
+ * @param center the center of the circle in screen space
+ * @param radius the radius in pixels
+ * @param color the color to draw it
+ */
+void gf2d_debug_draw_circle(GFC_Vector2D center,int radius,GFC_Color color);
+
+/**
+ * @brief draw everything buffered so far and empty the buffer
+ * @note called by gf2d_graphics_next_frame after the render queue
+ */
+void gf2d_debug_draw_flush();
+
+#else
+
+// empty stand-ins, real functions rather than macros so the arguments still count as used
+static inline void gf2d_debug_draw_init(Uint32 max_primitives){(void)max_primitives;}
+static inline void gf2d_debug_draw_point(GFC_Vector2D point,GFC_Color color){(void)point;(void)color;}
+static inline void gf2d_debug_draw_line(GFC_Vector2D p1,GFC_Vector2D p2,GFC_Color color){(void)p1;(void)p2;(void)color;}
+static inline void gf2d_debug_draw_rect(GFC_Rect rect,GFC_Color color){(void)rect;(void)color;}
+static inline void gf2d_debug_draw_circle(GFC_Vector2D center,int radius,GFC_Color color){(void)center;(void)radius;(void)color;}
+static inline void gf2d_debug_draw_flush(){}
+
+#endif
+
+#endif
@@ -31,6 +31,16 @@ void gf2d_draw_pixel(GFC_Vector2D pixel,GFC_Color color);
  */
 void gf2d_draw_circle(GFC_Vector2D center, int radius, GFC_Color color);
 
+/**
+ * @brief fill an array with the points of a circle outline
+ * @param points the array to fill
+ * @param max how many points the array has room for, radius * 8 is always enough
+ * @param center the center of the circle
+ * @param radius the radius of the circle
+ * @return the number of points written
+ */
+Uint32 gf2d_draw_circle_to_points(SDL_Point *points, Uint32 max, GFC_Vector2D center, int radius);
+
 /**
  * @brief draw a rectanlge outline
  * @param rect the rect to draw
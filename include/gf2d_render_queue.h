@@ -0,0 +1,53 @@
+#ifndef __GF2D_RENDER_QUEUE_H__
+#define __GF2D_RENDER_QUEUE_H__
+
+#include "gfc_types.h"
+#include "gfc_vector.h"
+#include "gfc_color.h"
+
+#include "gf2d_sprite.h"
+
+/**
+ * Layers are drawn in order, within a layer draws are sorted by depth and then by texture
+ */
+typedef enum
+{
+    RL_BACKGROUND = 0,  /**<backdrops behind the world*/
+    RL_TILES,           /**<the world's tiles*/
+    RL_ENTITIES,        /**<entities, y sorted so lower ones overlap higher ones*/
+    RL_FOREGROUND,      /**<anything drawn over the entities*/
+    RL_UI               /**<interface, always on top*/
+}RenderLayer;
+
+/**
+ * @brief initializes the render queue
+ * @param max_commands how many draws to make room for up front, the queue grows past this if needed
+ */
+void gf2d_render_queue_init(Uint32 max_commands);
+
+/**
+ * @brief queue a sprite draw for the end of the frame
+ * @note takes the same parameters as gf2d_sprite_render, plus where the draw sorts
+ * @param layer which RenderLayer the sprite belongs to
+ * @param depth sort order within the layer, lower depths are drawn first (use the y position for top down y sorting)
+ */
+void gf2d_render_queue_sprite(
+    Sprite * sprite,
+    GFC_Vector2D position,
+    GFC_Vector2D * scale,
+    GFC_Vector2D * center,
+    float    * rotation,
+    GFC_Vector2D * flip,
+    GFC_Color    * color,
+    GFC_Vector4D * clip,
+    Uint32 frame,
+    Uint8 layer,
+    float depth);
+
+/**
+ * @brief sort every queued draw and submit it to the sprite batch, then empty the queue
+ * @note called by gf2d_graphics_next_frame, draws made directly with the renderer before then end up below the queue
+ */
+void gf2d_render_queue_flush();
+
+#endif
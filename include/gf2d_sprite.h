@@ -7,6 +7,11 @@
 #include "gfc_vector.h"
 #include "gfc_text.h"
 
+#include "gf2d_batch.h"
+
+#define GF2D_SPRITE_MIP_LEVELS      3   /**<downscaled copies made of each sprite, half, quarter and eighth size*/
+#define GF2D_SPRITE_MIP_MIN_FRAME   4   /**<frames are not shrunk below this many pixels*/
+
 typedef struct Sprite_S
 {
     int ref_count;
@@ -15,8 +20,28 @@ typedef struct Sprite_S
     SDL_Surface *surface;
     Uint32 frames_per_line;
     Uint32 frame_w,frame_h;
+    Uint8  atlased;         /**<if true the texture is a shared atlas page and the sprite owns only atlas_rect of it*/
+    Uint32 atlas_page;      /**<which atlas page the sprite was packed into*/
+    SDL_Rect atlas_rect;    /**<where the sprite's image sits within the atlas page*/
+    Uint32 loading;         /**<nonzero while the image is being loaded asynchronously*/
+    Uint32 bytes;           /**<memory held by the sprite's own texture and kept surface*/
+    Uint32 last_used;       /**<when the sprite was last loaded or released, for evicting the least recently used*/
+    SDL_Texture *mips[GF2D_SPRITE_MIP_LEVELS];  /**<half, quarter and eighth size copies, drawn when the sprite is scaled down, never built for atlased sprites*/
+    Uint8 mip_count;        /**<how many of the mips exist, the chain stops early if frames do not divide evenly*/
 }Sprite;
 
+typedef struct
+{
+    Uint64 resident_bytes;      /**<memory held by every sprite's own texture and kept surface*/
+    Uint64 atlas_bytes;         /**<memory held by the atlas pages atlased sprites share, not part of resident_bytes*/
+    Uint64 budget;              /**<the memory budget, 0 if there is none*/
+    Uint32 resident_sprites;    /**<sprites that hold an image*/
+    Uint32 cached_sprites;      /**<of those, sprites nobody references that are kept in case they are loaded again*/
+    Uint32 lookups;             /**<loads requested*/
+    Uint32 hits;                /**<loads that found the sprite already in memory*/
+    Uint32 evictions;           /**<unreferenced sprites deleted to stay within the budget*/
+}SpriteStats;
+
 /**
  * @brief initializes the sprite manager 
  * @param max the maximum number of sprites the system will handle at once
@@ -53,6 +78,32 @@ Sprite *gf2d_sprite_load_all(
     Bool    keepSurface
 );
 
+/**
+ * @brief start loading a sprite in the background and return its handle right away
+ * @note the image is decoded on a loader thread and uploaded by gf2d_sprite_async_update,
+ *       until then the sprite draws a placeholder over its frame if the frame size was given.
+ *       If the image fails to load the handle stays valid but draws nothing
+ * @param filename the sprite sheet to load
+ * @param frameWidth the width of an individual sprite frame, -1 to use the whole image once it is loaded
+ * @param frameHeight the height of an individual sprite frame, -1 to use the whole image once it is loaded
+ * @param framesPerLine how many frames go in a row in the sprite sheet
+ * @param keepSurface if you plan on doing surface editing with this sprite, set to true otherwise the surface data is cleaned up
+ * @return NULL on error, otherwise the sprite, which may already be loaded if the file was loaded before
+ */
+Sprite *gf2d_sprite_load_async(
+    const char *filename,
+    Sint32 frameWidth,
+    Sint32 frameHeight,
+    Sint32 framesPerLine,
+    Bool    keepSurface
+);
+
+/**
+ * @brief upload images that finished loading in the background, call once a frame from the render thread
+ * @param budget roughly how many milliseconds to spend uploading this frame, at least one image is uploaded if any are ready
+ */
+void gf2d_sprite_async_update(Uint32 budget);
+
 /**
  * @brief draw a sprite to the screen with all options
  * @param sprite the sprite to draw
@@ -77,6 +128,31 @@ void gf2d_sprite_render(
     GFC_Vector4D * clip,
     Uint32 frame);
 
+/**
+ * @brief work out the screen quad a sprite draw covers without drawing it
+ * @note takes the same parameters as gf2d_sprite_render
+ * @param quad the quad to fill in
+ * @return 0 if there is nothing to draw, 1 otherwise
+ */
+Uint8 gf2d_sprite_get_quad(
+    Sprite * sprite,
+    GFC_Vector2D position,
+    GFC_Vector2D * scale,
+    GFC_Vector2D * center,
+    float    * rotation,
+    GFC_Vector2D * flip,
+    GFC_Color    * color,
+    GFC_Vector4D * clip,
+    Uint32 frame,
+    GF2D_Quad *quad);
+
+/**
+ * @brief get a small id for the texture a sprite draws from, for sorting draws by texture
+ * @param sprite the sprite
+ * @return the sprite's slot in the sprite manager, or an id shared by every sprite on the same atlas page
+ */
+Uint32 gf2d_sprite_get_texture_id(Sprite *sprite);
+
 /**
  * @brief draw a sprite to the screen
  * @param sprite the sprite to draw
@@ -100,11 +176,26 @@ void gf2d_sprite_draw(
 
 /**
  * @brief free a sprite back to the sprite manager
- * Stays in memory until the space is needed
+ * Stays in memory until the space is needed, or until the memory budget is exceeded
  * @param sprite the sprite to free
  */
 void gf2d_sprite_free(Sprite *sprite);
 
+/**
+ * @brief limit how much memory sprites that nobody references may keep resident
+ * @note when sprites take more than the budget the least recently used unreferenced sprites are deleted
+ *       until they fit. Referenced sprites are never evicted, so the budget can still be exceeded by them.
+ *       Textures shared through the atlas are not counted
+ * @param bytes the budget, 0 for no limit
+ */
+void gf2d_sprite_set_memory_budget(Uint64 bytes);
+
+/**
+ * @brief get the sprite manager's memory and cache statistics
+ * @param stats filled in with the current statistics
+ */
+void gf2d_sprite_get_stats(SpriteStats *stats);
+
 /**
  * @brief completely removes sprite from memory.  Only use when you know you wont need it again
  * @param sprite the sprite to delete
@@ -136,6 +227,24 @@ void gf2d_sprite_draw_to_surface(
     SDL_Surface *surface
 );
 
+/**
+ * @brief build the downscaled copies of a sprite drawn when it is scaled down
+ * @note sprites loaded from file get these automatically, this is for sprites whose texture is made by hand.
+ *       Atlased sprites get none so they keep drawing from their atlas page
+ * @param sprite the sprite, its frame size must already be set
+ * @param surface the image the sprite's texture was made from, 32 bits per pixel
+ */
+void gf2d_sprite_build_mips(Sprite *sprite,SDL_Surface *surface);
+
+/**
+ * @brief redraw part of a sprite's downscaled copies after that part of its texture changed
+ * @note if the region does not line up with the smallest copy's pixels the copies are dropped instead
+ * @param sprite the sprite whose texture was updated
+ * @param surface the new pixels of the region, 32 bits per pixel
+ * @param region where the surface sits within the full size texture
+ */
+void gf2d_sprite_update_mips(Sprite *sprite,SDL_Surface *surface,SDL_Rect region);
+
 /**
  * @brief allocate space for a sprite
  * @note both texture and sprite data is left blank
@@ -0,0 +1,38 @@
+#ifndef __JOB_H__
+#define __JOB_H__
+
+#include "gfc_types.h"
+
+/**
+ * @brief a job processes the items in [begin, end)
+ * @param begin first item in the range
+ * @param end one past the last item in the range
+ * @param worker index of the worker running the range, ranges are handed out in worker order
+ * @param data user data passed to job_system_run
+ */
+typedef void (*JobFunction)(Uint32 begin, Uint32 end, Uint32 worker, void *data);
+
+/**
+ * @brief start the worker threads
+ * @param thread_count how many threads (including the calling thread) to run jobs on, 0 for one per cpu core
+ * @note if this is never called every job runs on the calling thread
+ */
+void job_system_init(Uint32 thread_count);
+
+/**
+ * @brief get how many workers jobs can be split across, including the calling thread
+ * @return at least 1
+ */
+Uint32 job_system_worker_count();
+
+/**
+ * @brief split a range of items into contiguous chunks and run them across the workers, waiting for all of them
+ * @param count how many items there are
+ * @param min_per_worker the smallest chunk worth handing to its own worker
+ * @param job the function run on each chunk
+ * @param data passed through to the job
+ * @return how many workers were used, worker i always gets the i-th chunk
+ */
+Uint32 job_system_run(Uint32 count, Uint32 min_per_worker, JobFunction job, void *data);
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef __JOINT_H__
+#define __JOINT_H__
+
+#include "gfc_vector.h"
+
+#include "body.h"
+
+#define JOINT_BAUMGARTE	0.2	// <Fraction of a rigid joint's position error corrected each step
+
+typedef enum {
+	JT_DISTANCE,	//<Keeps the anchors a fixed distance apart, such as a rope or chain link
+	JT_PIN,		//<Keeps the anchors at the same point
+	JT_SPRING	//<Pulls the anchors towards a rest length with a stiffness and damping
+}JointType;
+
+typedef struct Joint_S {
+	JointType	type;		// <What the joint constrains
+	Body		*a;		// <The first body
+	Body		*b;		// <The second body, NULL to attach the first body to a fixed point in the world
+	GFC_Vector2D	anchor_a;	// <Where the joint attaches to a, relative to a's position
+	GFC_Vector2D	anchor_b;	// <Where the joint attaches to b relative to b's position, or in world space if b is NULL
+	float		length;		// <Distance kept between the anchors by distance and spring joints
+	float		stiffness;	// <Spring stiffness, force per unit of stretch
+	float		damping;	// <Spring damping, force per unit of stretching speed
+
+	// Solver state
+	GFC_Vector2D	impulse;	// <Accumulated impulse, kept between steps for warm starting (only x is used along the axis)
+	GFC_Vector2D	axis;		// <Direction from a's anchor to b's anchor this step
+	GFC_Vector2D	bias;		// <Velocity that feeds the position error back into the solve
+	float		mass;		// <Effective mass of the constraint
+	float		gamma;		// <Softness of a spring, 0 for rigid joints
+	Uint8		active;		// <Whether the joint is solved this step, joints between sleeping bodies are skipped
+	Uint32		color;		// <The batch the joint was put in by the solver's graph coloring
+}Joint;
+
+/**
+ * @brief create a joint that keeps two anchors at their current distance
+ * @param a the first body
+ * @param b the second body, NULL to hang a from a fixed world point
+ * @param anchor_a where the joint attaches to a, relative to a's position
+ * @param anchor_b where the joint attaches to b, relative to b's position, or in world space if b is NULL
+ * @return NULL if failed to allocate memory, otherwise the new joint
+ */
+Joint *joint_new_distance(Body *a, Body *b, GFC_Vector2D anchor_a, GFC_Vector2D anchor_b);
+
+/**
+ * @brief create a joint that keeps two anchors at the same point
+ * @param a the first body
+ * @param b the second body, NULL to pin a to a fixed world point
+ * @param anchor_a where the joint attaches to a, relative to a's position
+ * @param anchor_b where the joint attaches to b, relative to b's position, or in world space if b is NULL
+ * @return NULL if failed to allocate memory, otherwise the new joint
+ */
+Joint *joint_new_pin(Body *a, Body *b, GFC_Vector2D anchor_a, GFC_Vector2D anchor_b);
+
+/**
+ * @brief create a damped spring between two anchors
+ * @param a the first body
+ * @param b the second body, NULL to attach a to a fixed world point
+ * @param anchor_a where the joint attaches to a, relative to a's position
+ * @param anchor_b where the joint attaches to b, relative to b's position, or in world space if b is NULL
+ * @param length the rest length of the spring
+ * @param stiffness force per unit of stretch
+ * @param damping force per unit of stretching speed
+ * @return NULL if failed to allocate memory, otherwise the new joint
+ * @note springs are solved as soft constraints, so they stay stable at any stiffness
+ */
+Joint *joint_new_spring(Body *a, Body *b, GFC_Vector2D anchor_a, GFC_Vector2D anchor_b, float length, float stiffness, float damping);
+
+/**
+ * @brief free a joint
+ * @param self the joint to be freed
+ * @note remove the joint from its space first with space_remove_joint
+ */
+void joint_free(Joint *self);
+
+/**
+ * @brief compute the joint's axis, effective mass and bias for this step, then apply the warm start impulse
+ * @param self the joint to be prepared
+ * @param delta_time the time that passes in the step
+ * @note wakes a sleeping body attached to an awake one
+ */
+void joint_prepare(Joint *self, float delta_time);
+
+/**
+ * @brief run one sequential impulse iteration on the joint
+ * @param self the joint to be solved
+ * @note joints that share no bodies can be solved at the same time
+ */
+void joint_solve(Joint *self);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef __NARROWPHASE_H__
+#define __NARROWPHASE_H__
+
+#include "gfc_list.h"
+
+#include "broadphase.h"
+#include "collision.h"
+
+struct Space_S;
+
+#define NARROWPHASE_MIN_PAIRS_PER_THREAD	64	// <Below this many pairs per thread the work is not split any further
+
+/**
+ * @brief allocate one contact buffer per job worker
+ * @note call after job_system_init(), otherwise only one buffer is made and the narrowphase runs on the calling thread.
+ *       If this is never called it is done on the first run.
+ */
+void narrowphase_init();
+
+/**
+ * @brief test every candidate pair for contact, splitting the pairs across the job workers
+ * @param space the space the pairs came from, for its static shapes and tile grid
+ * @param pairs the candidate pairs produced by the broadphase
+ * @param pair_count how many pairs there are
+ * @param contacts the buffer that receives the contacts, cleared first
+ * @note each thread writes to its own buffer and the buffers are merged in pair order,
+ *       so the contacts produced do not depend on the number of threads.
+ *       Tile grid pairs test circles against the candidate tiles with collision_circle_rect_batch.
+ */
+void narrowphase_run(struct Space_S *space, CollisionPair *pairs, Uint32 pair_count, ContactBuffer *contacts);
+
+#endif
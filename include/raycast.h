@@ -0,0 +1,59 @@
+#ifndef __RAYCAST_H__
+#define __RAYCAST_H__
+
+#include "gfc_vector.h"
+
+#include "space.h"
+
+typedef struct {
+	GFC_Vector2D	origin;		// <Where the ray starts in world space
+	GFC_Vector2D	direction;	// <Which way the ray points, does not need to be normalized
+	float		max_distance;	// <How far the ray travels before giving up
+}Ray;
+
+typedef struct {
+	Uint8		hit;		// <Whether anything was hit
+	float		distance;	// <Distance travelled along the ray before the hit
+	GFC_Vector2D	point;		// <Where the ray (or the cast circle's center) was when it hit
+	GFC_Vector2D	normal;		// <The surface normal of the tile that was hit
+	Sint32		tile_x;		// <Column of the tile that was hit
+	Sint32		tile_y;		// <Row of the tile that was hit
+}RaycastHit;
+
+/**
+ * @brief cast a ray through the space's tile grid and find the first solid tile it hits
+ * @param self the space whose tile grid is searched
+ * @param origin where the ray starts
+ * @param direction which way the ray points, does not need to be normalized
+ * @param max_distance how far the ray travels
+ * @param hit (optional) receives the details of the first hit
+ * @return 1 if a tile was hit, 0 otherwise
+ * @note walks the grid cell by cell (Amanatides-Woo DDA), so the cost is proportional to the cells crossed.
+ *       One way tiles only stop rays that come down onto their top face.
+ */
+Uint8 space_raycast(Space *self, GFC_Vector2D origin, GFC_Vector2D direction, float max_distance, RaycastHit *hit);
+
+/**
+ * @brief sweep a circle through the space's tile grid and find the first solid tile it touches
+ * @param self the space whose tile grid is searched
+ * @param origin where the circle's center starts
+ * @param radius the radius of the circle
+ * @param direction which way the circle moves, does not need to be normalized
+ * @param max_distance how far the circle moves
+ * @param hit (optional) receives the details of the first hit, point is the circle's center at contact
+ * @return 1 if a tile was hit, 0 otherwise
+ * @note a circle that starts overlapping a tile only hits it if it is moving further into it
+ */
+Uint8 space_circle_cast(Space *self, GFC_Vector2D origin, float radius, GFC_Vector2D direction, float max_distance, RaycastHit *hit);
+
+/**
+ * @brief cast many rays at once through the space's tile grid
+ * @param self the space whose tile grid is searched
+ * @param rays the rays to be cast
+ * @param count how many rays there are
+ * @param hits receives one hit record per ray, in the same order as the rays
+ * @return the number of rays that hit something
+ */
+Uint32 space_raycast_batch(Space *self, const Ray *rays, Uint32 count, RaycastHit *hits);
+
+#endif
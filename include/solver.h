@@ -0,0 +1,59 @@
+#ifndef __SOLVER_H__
+#define __SOLVER_H__
+
+#include "gfc_list.h"
+
+#include "collision.h"
+#include "joint.h"
+
+#define SOLVER_ITERATIONS	2	// <Default number of velocity iterations per step
+#define SOLVER_SLOP		0.5	// <Penetration depth that is allowed before positions are corrected
+#define SOLVER_CORRECTION	0.8	// <Fraction of the remaining penetration corrected each step
+#define SOLVER_JOINT_ITERATIONS	8	// <Default number of velocity iterations per step for joints
+#define SOLVER_JOINT_COLORS	64	// <Most colors a joint can be given, joints past that go into one extra serial batch
+#define SOLVER_JOINTS_PER_WORKER 128	// <Smallest run of a batch worth handing to its own worker
+
+typedef struct {
+	Joint		**joints;	// <The joints sorted by color, so each batch is contiguous
+	Uint32		joint_count;	// <Number of joints in the array
+	Uint32		joint_capacity;	// <Number of joints the array can hold
+	Uint32		batch_start[SOLVER_JOINT_COLORS + 2];// <Index of each batch's first joint, the last entry is joint_count
+	Uint32		batch_count;	// <Number of batches in use, the serial batch is always last if used
+	Uint8		dirty;		// <Set when joints were added or removed and the batches must be rebuilt
+}JointBatches;
+
+/**
+ * @brief resolve contacts with sequential impulses, warm started from the contact cache
+ * @param contacts the contacts found this step
+ * @param cache the cache of accumulated impulses, updated with this step's results
+ * @param iterations how many velocity iterations to run
+ * @note the cached impulse is applied before iterating, so resting contacts start close to
+ *       their solution and only need one or two iterations to converge.
+ *       Sleeping bodies are solved as immovable, they are neither pushed nor given velocity
+ */
+void solver_solve_contacts(ContactBuffer *contacts, ContactCache *cache, Uint32 iterations);
+
+/**
+ * @brief sort joints into batches with graph coloring, so no two joints in a batch share a body
+ * @param batches the batches to be rebuilt
+ * @param joints the list of every joint
+ * @note joints in a batch can be solved in parallel without racing on a body's velocity
+ */
+void solver_color_joints(JointBatches *batches, GFC_List *joints);
+
+/**
+ * @brief resolve joints with sequential impulses, one batch at a time, splitting large batches across the job workers
+ * @param batches the colored joints
+ * @param iterations how many velocity iterations to run
+ * @param delta_time the time that passes in the step
+ * @note call between integrating velocity and position so the joints see this step's forces
+ */
+void solver_solve_joints(JointBatches *batches, Uint32 iterations, float delta_time);
+
+/**
+ * @brief free the memory used by joint batches
+ * @param batches the batches to be cleaned up, the joints themselves are not freed
+ */
+void solver_joint_batches_free(JointBatches *batches);
+
+#endif
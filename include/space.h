@@ -7,8 +7,29 @@
 
 #include "body.h"
 #include "entity.h"
+#include "collision.h"
+#include "broadphase.h"
+#include "tiledata.h"
+#include "trigger.h"
+#include "joint.h"
+#include "solver.h"
+
+#define SPACE_SLEEP_VELOCITY	0.01	// <Default speed below which a body is considered at rest
+#define SPACE_SLEEP_STEPS	30	// <Default number of resting steps before a body falls asleep
+#define SPACE_UPDATE_TIME	1.0	// <Simulated time that passes in a single space update
+#define SPACE_MAX_SUBSTEPS	10	// <Default cap on how many steps a body's update can be split into
+#define SPACE_SUBSTEP_TRAVEL	0.5	// <Furthest a body may move in one step, as a fraction of its size
 
 typedef struct {
+	Sint32		x;		//<Column of the tile
+	Sint32		y;		//<Row of the tile
+	TileData	*tile;		//<The tile's data
+	GFC_Vector2D	poc;		//<Point of contact on the tile's surface
+	GFC_Vector2D	normal;		//<Contact normal pointing from the tile towards the circle
+	float		depth;		//<How far the circle overlaps the tile
+}TileOverlap;
+
+typedef struct Space_S {
 
 	// Debug stuff
 	GFC_TextLine	name;		//<The name of the space for debugging purposes
@@ -16,6 +37,36 @@ typedef struct {
 	// Physics bodies in the space
 	GFC_List	*static_shapes;	//<List of all static shapes in the physics space
 	GFC_List	*bodies;	//<List of all dynamic physics bodies in the physics space
+	Uint32		static_layer;	//<The collision layer the static shapes and tile grid belong to
+	GFC_List	*triggers;	//<List of all trigger volumes in the physics space
+	Uint8		triggers_dirty;	//<Set when a body was awake, was moved by its entity, or a body or trigger was added since the triggers were last updated
+	GFC_List	*joints;	//<List of all joints between bodies in the physics space
+
+	// Sleep config
+	float		sleep_velocity;	//<Speed (and acceleration) below which a body is considered at rest
+	Uint32		sleep_steps;	//<Number of consecutive resting steps before a body is put to sleep
+
+	// Substep config
+	Uint32		max_substeps;	//<Most steps a single body's update can be split into
+
+	// Collision detection
+	Broadphase	broadphase;	//<Candidate pair finder for bodies and static shapes
+	ContactBuffer	contacts;	//<Contacts found during the last step
+
+	// Collision resolution
+	ContactCache	contact_cache;	//<Accumulated contact impulses kept between steps for warm starting
+	Uint32		solver_iterations;//<Number of velocity iterations used to resolve contacts
+	Uint32		next_body_id;	//<The last id handed out to a body added to the space
+	JointBatches	joint_batches;	//<The joints grouped into batches that share no bodies
+	Uint32		joint_iterations;//<Number of velocity iterations used to resolve joints
+
+	// Tile grid (owned by the world, not the space)
+	Uint32		*tile_map;	//<The tile ids of every grid cell, NULL if the space has no tile grid
+	TileData	*tile_data;	//<Tile data indexed by tile id - 1
+	Uint32		tile_count;	//<Number of entries in tile_data
+	Uint32		grid_width;	//<Width of the tile grid in cells
+	Uint32		grid_height;	//<Height of the tile grid in cells
+	float		tile_size;	//<Width and height of a grid cell
 
 }Space;
 
@@ -39,6 +90,61 @@ void space_free(Space *self);
  */
 void space_add_static_shape(Space *self, GFC_Shape shape);
 
+/**
+ * @brief attach a tile grid to the space for grid queries such as raycasts
+ * @param self the space the grid is attached to
+ * @param tile_map the tile ids of every cell in row major order, 0 for air
+ * @param tile_data the tile data array indexed by tile id - 1
+ * @param tile_count the number of entries in tile_data
+ * @param width the width of the grid in cells
+ * @param height the height of the grid in cells
+ * @param tile_size the width and height of a cell, the grid's top left corner is at (0,0)
+ * @note the space only references the arrays, they must outlive it
+ */
+void space_set_tile_grid(Space *self, Uint32 *tile_map, TileData *tile_data, Uint32 tile_count, Uint32 width, Uint32 height, float tile_size);
+
+/**
+ * @brief get the tile data of the solid tile in a grid cell
+ * @param self the space whose grid is checked
+ * @param x the column of the cell
+ * @param y the row of the cell
+ * @return NULL if the cell is outside the grid, empty, or has no collision, otherwise the cell's tile data
+ */
+TileData *space_get_solid_tile(Space *self, Sint32 x, Sint32 y);
+
+/**
+ * @brief let the space know a cell of its tile grid changed, waking the bodies around it
+ * @param self the space whose grid changed
+ * @param x the column of the cell
+ * @param y the row of the cell
+ * @note collision reads the grid directly, so nothing needs rebuilding. Bodies resting on or
+ *       against the cell are woken so they fall or get pushed out instead of sleeping through the change.
+ */
+void space_tile_changed(Space *self, Sint32 x, Sint32 y);
+
+/**
+ * @brief get the world space collision rect of a tile
+ * @param self the space the tile belongs to
+ * @param tile the tile's data
+ * @param x the column of the tile
+ * @param y the row of the tile
+ * @return the tile's collision box placed at the cell's top left corner
+ */
+GFC_Rect space_get_tile_rect(Space *self, TileData *tile, Sint32 x, Sint32 y);
+
+/**
+ * @brief find every solid tile overlapping a circle
+ * @param self the space whose tile grid is searched
+ * @param circle the circle in world space
+ * @param callback called once per overlapping tile
+ * @param data passed through to the callback
+ * @return the number of overlapping tiles
+ * @note the candidate tiles are tested in batches with collision_circle_rect_batch.
+ *       One way tiles only overlap circles whose center is above them being pushed up.
+ *       Only reads the space, so it is safe to call from several threads at once.
+ */
+Uint32 space_overlap_circle_tiles(Space *self, GFC_Circle circle, void (*callback)(const TileOverlap *overlap, void *data), void *data);
+
 /**
  * @brief add an entity body to the list of bodies in the world
  * @param self the space object to be modified
@@ -47,31 +153,90 @@ void space_add_static_shape(Space *self, GFC_Shape shape);
 void space_add_entity(Space *self, Entity *ent);
 
 /**
- * @brief for debugging purposes, draws all static shapes in the space
+ * @brief remove a body from the space without freeing it
+ * @param self the space the body is removed from
+ * @param body the body to be removed
+ * @note joints attached to the body are removed and freed with it
+ */
+void space_remove_body(Space *self, Body *body);
+
+/**
+ * @brief add a trigger volume to the space, the space takes ownership of it
+ * @param self the space the trigger is added to
+ * @param trigger the trigger to be added
+ * @note set self->triggers_dirty after moving a trigger's shape so its overlap set is rebuilt
+ */
+void space_add_trigger(Space *self, Trigger *trigger);
+
+/**
+ * @brief remove a trigger volume from the space and free it
+ * @param self the space the trigger is removed from
+ * @param trigger the trigger to be removed
+ */
+void space_remove_trigger(Space *self, Trigger *trigger);
+
+/**
+ * @brief add a joint to the space, the space takes ownership of it
+ * @param self the space the joint is added to
+ * @param joint the joint to be added, its bodies should already be in the space
+ */
+void space_add_joint(Space *self, Joint *joint);
+
+/**
+ * @brief remove a joint from the space and free it
+ * @param self the space the joint is removed from
+ * @param joint the joint to be removed
+ */
+void space_remove_joint(Space *self, Joint *joint);
+
+/**
+ * @brief for debugging purposes, draws the static shapes and solid tiles in the space that the main camera can see
  */
 void space_draw(Space *self);
 
 // Simulation calls
 
 /**
- * @brief take a simulation step
+ * @brief take a simulation step, moving every awake body once
  * @param self the space object to be stepped
  * @param delta_time the time that passes in a single step
  */
 void space_step(Space *self, float delta_time);
 
+/**
+ * @brief pick how many steps each awake body is split into for an update
+ * @param self the space being updated
+ * @param delta_time the time that passes in the update
+ * @return the largest substep count of any body, which is how many times the space collides during the update
+ * @note a body subdivides by how far it moves relative to the smaller of its collider size and the tile size,
+ *       capped by max_substeps. Bodies attached to joints take the largest count so their joints see one step size.
+ */
+Uint32 space_plan_substeps(Space *self, float delta_time);
+
+/**
+ * @brief find every contact between bodies and between bodies and static shapes
+ * @param self the space to collide
+ * @note results are stored in self->contacts, sleeping bodies are woken only when a body that is still moving touches them
+ */
+void space_collide(Space *self);
+
 /**
  * @brief update the physics space
  * @param self the space object to be updated
+ * @note slow bodies take a single step while fast ones subdivide, see space_plan_substeps.
+ *       Contact impulses that were not used during the update are dropped from the cache afterwards,
+ *       then triggers are updated against the bodies' final positions.
+ *       While every body is asleep the overlap sets cannot change, so triggers only repeat on_stay
  */
 void space_update(Space *self);
 
 // Collision/overlap checking
 
 /**
- * @brief check if an entity is overlapping with any static shape in the space
+ * @brief check if an entity is overlapping with any static shape or solid tile in the space
  * @param entity the entity whose bounds are being checked with static shapes in the world
- * @return a list of shape overlaps as Vector2Ds
+ * @return a list of shape overlaps as Vector2Ds, NULL if there are none, the entity's body is asleep,
+ *         or the body's mask excludes the static layer
  * @note this list is not freed on its own, and must be freed by the function caller
  */
 GFC_List *space_overlap_entity_static_shape(Space *self, Entity *entity);
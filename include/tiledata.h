@@ -3,6 +3,8 @@
 
 #include "gfc_vector.h"
 
+#define TILE_ANIM_MAX_FRAMES	16	// <Most frames a tile animation can cycle through
+
 typedef enum {
 	TCT_NONE = 0,	// <No collision, player will pass through block
 	TCT_FULL = 1,	// <Full collision, block will stop player
@@ -12,6 +14,11 @@ typedef enum {
 typedef struct {
 	// Draw data
 	Uint32			frame;	// <Which frame this tile represents
+
+	// Animation data
+	Uint32			anim_frames[TILE_ANIM_MAX_FRAMES];	// <Tile set frames the tile cycles through
+	Uint32			anim_frame_count;	// <Number of animation frames, 0 if the tile is not animated
+	Uint32			anim_frame_duration;	// <How long each animation frame is shown in milliseconds
 	
 	// Collision data
 	TileCollisionType	collision_type;	// <The type of collision this tile
@@ -0,0 +1,64 @@
+#ifndef __TRIGGER_H__
+#define __TRIGGER_H__
+
+#include "gfc_shape.h"
+
+#include "body.h"
+#include "broadphase.h"
+
+typedef struct Trigger_S {
+	GFC_Shape	shape;		// <The trigger's volume in world space
+	Uint32		mask;		// <The body layers that can trip the trigger
+
+	// Overlap set, kept sorted by body id
+	Body		**overlaps;	// <Bodies currently inside the trigger
+	Uint32		overlap_count;	// <Number of bodies inside the trigger
+	Body		**scratch;	// <Buffer the next overlap set is built in
+	Uint32		scratch_count;	// <Number of bodies in the scratch buffer
+	Uint32		capacity;	// <Number of bodies both buffers can hold
+
+	// Callbacks
+	void		*data;		// <(optional) user data for the callbacks
+	void		(*on_enter)(struct Trigger_S *self, Body *body);	// <(optional) called when a body starts overlapping
+	void		(*on_stay)(struct Trigger_S *self, Body *body);		// <(optional) called every update for each body still overlapping
+	void		(*on_exit)(struct Trigger_S *self, Body *body);		// <(optional) called when a body stops overlapping
+}Trigger;
+
+/**
+ * @brief allocate memory for a new trigger
+ * @param shape the trigger's volume in world space
+ * @param mask the body layers that can trip the trigger
+ * @return NULL if failed to allocate memory, otherwise a trigger with no callbacks set
+ */
+Trigger *trigger_new(GFC_Shape shape, Uint32 mask);
+
+/**
+ * @brief free a trigger
+ * @param self the trigger to be freed
+ * @note on_exit is not called for the bodies still inside
+ */
+void trigger_free(Trigger *self);
+
+/**
+ * @brief rebuild the trigger's overlap set and fire callbacks for bodies that entered or left
+ * @param self the trigger to be updated
+ * @param broadphase the broadphase used to find candidate bodies
+ * @note callbacks must not free bodies directly, mark the entity and free it in its update instead
+ */
+void trigger_update(Trigger *self, Broadphase *broadphase);
+
+/**
+ * @brief fire on_stay for every body in the trigger's overlap set without rebuilding it
+ * @param self the trigger to be updated
+ * @note only valid while no body has moved since the last trigger_update
+ */
+void trigger_stay(Trigger *self);
+
+/**
+ * @brief remove a body from the trigger's overlap set, firing on_exit if it was inside
+ * @param self the trigger to be modified
+ * @param body the body being removed
+ */
+void trigger_remove_body(Trigger *self, Body *body);
+
+#endif
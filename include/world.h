@@ -12,15 +12,49 @@
 #include "tiledata.h"
 #include "space.h"
 
+#define WORLD_CHUNK_SIZE	1024	// <Largest width and height in pixels of a baked tile layer chunk
+#define WORLD_CHUNK_CACHE	16	// <Baked chunks kept once they go off screen, more are kept while they are all in view
+
+#define WORLD_MAX_PARALLAX_LAYERS	8	// <Most parallax layers a world can have
+#define WORLD_PARALLAX_CELL		256	// <Parallax images are drawn in cells this many pixels wide and high, off screen cells are skipped
+
+typedef enum {
+	PR_NONE = 0,	// <The image is drawn once
+	PR_X = 1,	// <The image repeats horizontally
+	PR_Y = 2,	// <The image repeats vertically
+	PR_BOTH = 3	// <The image repeats in both directions
+}ParallaxRepeat;
+
+typedef struct
+{
+	Sprite		*sprite;	// <The layer's image
+	float		scroll_factor;	// <How far the layer moves relative to the camera, 0 is fixed to the screen and 1 moves with the world
+	ParallaxRepeat	repeat;		// <Which directions the image repeats in
+	GFC_Vector2D	offset;		// <Where the image's top left corner sits relative to the screen center when the camera is at the origin
+	Uint8		in_front;	// <If true the layer is drawn over the entities instead of behind the tiles
+}ParallaxLayer;
+
+typedef enum {
+	TRM_BAKED,	// <Tiles are baked into chunk textures as they come into view
+	TRM_DYNAMIC	// <Visible tiles are drawn straight from the tile set every frame
+}TileRenderMode;
+
+typedef struct
+{
+	Sint32		x, y;		// <The chunk's column and row in the chunk grid
+	Sprite		*sprite;	// <The baked tiles of the chunk
+	SDL_Rect	dirty;		// <Tiles edited since the chunk was baked, in tiles relative to the chunk, clean if w is 0
+	Uint32		last_used;	// <The frame the chunk was last drawn on
+}TileChunk;
+
 typedef struct
 {
 	// Object metadata
 	GFC_TextLine	name;
 
-	// World background sprites
-	Sprite		*background;	// <The static background image
-	Sprite		*foreground;	// <The parallax foreground image
-	float		bg_factor;	// <The parallax factor
+	// Parallax layers, drawn in order
+	ParallaxLayer	parallax[WORLD_MAX_PARALLAX_LAYERS];	// <The world's backdrops
+	Uint32		parallax_count;	// <Number of parallax layers in use
 	
 	// Tileset config
 	Sprite		*tile_set;	// <The tileset sprite of this world
@@ -31,9 +65,17 @@ typedef struct
 	Uint32		tile_count;	// <The number of tiles in the tileset
 	TileData*	tile_data;	// <An array of tile data, reserve 0 for air tiles
 	Uint32*		tile_map;	// <The map of tiles in the level
+	Uint32*		animated_tiles;	// <Tile map indices of every animated tile, sorted, these are drawn over the tile layer
+	Uint32		animated_count;	// <Number of animated tiles in the map
+	Uint32		animated_capacity;	// <Number of animated tile indices allocated
 	
-	// Tile layer(s)
-	Sprite		*tile_layer;	// <The sprite which tiles will be drawn onto
+	// Tile layer(s), baked in chunks as they come into view
+	TileRenderMode	render_mode;	// <How the tile map is drawn
+	Uint32		chunk_size;	// <The width and height of a chunk in pixels, a whole number of tiles
+	TileChunk	*chunks;	// <The cache of baked chunks
+	Uint32		chunk_count;	// <Number of chunks baked
+	Uint32		chunk_capacity;	// <Number of chunks allocated
+	Uint32		chunk_frame;	// <Counts world_draw calls, for finding the least recently drawn chunk
 	
 	// Physics Info
 	Space		*space;		// <The world's physics space for physics simulation
@@ -77,6 +119,24 @@ World *world_new(Uint32 width, Uint32 height, Uint32 tile_count);
  */
 World *world_load(const char *filename);
 
+/**
+ * @brief change a single tile of the world's tile map
+ * @param world the world to be modified
+ * @param x the column of the tile
+ * @param y the row of the tile
+ * @param id the new tile id, 0 for air
+ * @return 1 if the tile changed, 0 if it was out of bounds, the id was invalid, or the tile already had that id
+ * @note only the one cell is touched, the physics space collides against the tile map directly
+ *       and a baked chunk holding the tile re-uploads just its edited tiles the next time it is drawn
+ */
+Uint8 world_set_tile(World *world, Uint32 x, Uint32 y, Uint32 id);
+
+/**
+ * @brief drop every baked tile layer chunk, they are rebaked as they come back into view
+ * @param world the world whose chunks should be freed
+ */
+void world_free_tile_chunks(World *world);
+
 /**
  * @brief draws the world's tilemap
  * @param world the world object to be drawn
@@ -1,6 +1,20 @@
 #include "simple_logger.h"
 
 #include "body.h"
+#include "space.h"
+#include "character.h"
+
+static const struct {
+	const char	*name;
+	Uint32		layer;
+}body_layer_names[] = {
+	{"world", BL_WORLD},
+	{"player", BL_PLAYER},
+	{"enemy", BL_ENEMY},
+	{"projectile", BL_PROJECTILE},
+	{"prop", BL_PROP},
+	{"all", BL_ALL}
+};
 
 Body *body_new() {
 	// Allocate memory
@@ -10,12 +24,76 @@ Body *body_new() {
 		slog("failed to allocate memory for physics body");
 		return NULL;
 	}
+	body->inv_mass = 1;
+
+	// Collide with everything by default
+	body->layer = BL_PROP;
+	body->mask = BL_ALL;
 
 	return body;
 }
 
 void body_free(Body *self) {
 	if (!self) return;
+	if (self->space) space_remove_body(self->space, self);
+	if (self->controller) character_free(self->controller);
 	slog ("freeing the body");
 	free(self);
 }
+
+Uint8 body_can_collide(Body *a, Body *b) {
+	if (!a || !b) return 0;
+	if (!(a->layer & b->mask) || !(b->layer & a->mask)) return 0;
+	if (a->owner == b || b->owner == a) return 0;
+	return 1;
+}
+
+Uint32 body_layer_from_name(const char *name) {
+	int i;
+	if (!name) return BL_NONE;
+	for (i = 0; i < sizeof(body_layer_names) / sizeof(body_layer_names[0]); ++i) {
+		if (strcmp(body_layer_names[i].name, name) == 0) return body_layer_names[i].layer;
+	}
+	slog("unknown collision layer '%s'", name);
+	return BL_NONE;
+}
+
+void body_set_mass(Body *self, float mass) {
+	if (!self) return;
+	self->inv_mass = (mass > 0) ? 1.0 / mass : 0;
+}
+
+GFC_Shape body_world_collider(Body *self) {
+	GFC_Shape shape = self->collider;
+	switch (shape.type) {
+		case ST_CIRCLE:
+			shape.s.c.x += self->position.x;
+			shape.s.c.y += self->position.y;
+			break;
+		case ST_RECT:
+			shape.s.r.x += self->position.x;
+			shape.s.r.y += self->position.y;
+			break;
+		case ST_EDGE:
+			shape.s.e.x1 += self->position.x;
+			shape.s.e.y1 += self->position.y;
+			shape.s.e.x2 += self->position.x;
+			shape.s.e.y2 += self->position.y;
+			break;
+	}
+	return shape;
+}
+
+void body_wake(Body *self) {
+	if (!self) return;
+	self->sleeping = 0;
+	self->rest_steps = 0;
+}
+
+void body_sleep(Body *self) {
+	if (!self) return;
+	self->sleeping = 1;
+	self->velocity = gfc_vector2d(0, 0);
+	self->acceleration = gfc_vector2d(0, 0);
+	self->net_acceleration = gfc_vector2d(0, 0);
+}
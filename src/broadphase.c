@@ -0,0 +1,191 @@
+#include "simple_logger.h"
+
+#include "broadphase.h"
+#include "collision.h"
+
+/**
+ * @brief get a new pair slot at the end of the pair array, growing it if needed
+ * @param self the broadphase whose pair array is being appended to
+ * @return NULL if failed to allocate memory, otherwise the new pair
+ */
+static CollisionPair *broadphase_push_pair(Broadphase *self) {
+	CollisionPair *grown;
+	Uint32 capacity;
+	if (self->pair_count >= self->pair_capacity) {
+		capacity = self->pair_capacity ? self->pair_capacity * 2 : 64;
+		grown = realloc(self->pairs, sizeof(CollisionPair) * capacity);
+		if (!grown) {
+			slog("failed to grow broadphase pair array to %i pairs", capacity);
+			return NULL;
+		}
+		self->pairs = grown;
+		self->pair_capacity = capacity;
+	}
+	return &self->pairs[self->pair_count++];
+}
+
+/**
+ * @brief copy the space's bodies into the proxy array
+ * @param self the broadphase being updated
+ * @param bodies the list of bodies in the space
+ * @return 0 on success, -1 if memory could not be allocated
+ */
+static int broadphase_build_proxies(Broadphase *self, GFC_List *bodies) {
+	Uint32 i, c;
+	Body *body;
+	BroadphaseProxy *grown;
+
+	c = gfc_list_count(bodies);
+	if (c > self->proxy_capacity) {
+		grown = realloc(self->proxies, sizeof(BroadphaseProxy) * c);
+		if (!grown) {
+			slog("failed to grow broadphase proxy array to %i proxies", c);
+			return -1;
+		}
+		self->proxies = grown;
+		self->proxy_capacity = c;
+	}
+
+	self->proxy_count = 0;
+	self->max_width = 0;
+	for (i = 0; i < c; ++i) {
+		body = gfc_list_get_nth(bodies, i);
+		if (!body) continue;
+		self->proxies[self->proxy_count].body = body;
+		self->proxies[self->proxy_count].bounds = collision_shape_bounds(body_world_collider(body));
+		self->max_width = MAX(self->max_width, self->proxies[self->proxy_count].bounds.w);
+		self->proxy_count++;
+	}
+	return 0;
+}
+
+/**
+ * @brief sort proxies by the left edge of their bounds
+ * @param self the broadphase whose proxies are sorted
+ * @note insertion sort, since the bodies list order barely changes between steps
+ */
+static void broadphase_sort_proxies(Broadphase *self) {
+	Uint32 i;
+	Sint32 j;
+	BroadphaseProxy key;
+	for (i = 1; i < self->proxy_count; ++i) {
+		key = self->proxies[i];
+		for (j = (Sint32)i - 1; j >= 0 && self->proxies[j].bounds.x > key.bounds.x; --j) {
+			self->proxies[j + 1] = self->proxies[j];
+		}
+		self->proxies[j + 1] = key;
+	}
+}
+
+/**
+ * @brief check if two rects overlap, touching edges count as overlapping
+ */
+static Uint8 broadphase_bounds_overlap(GFC_Rect a, GFC_Rect b) {
+	return !(a.x > b.x + b.w || b.x > a.x + a.w || a.y > b.y + b.h || b.y > a.y + a.h);
+}
+
+void broadphase_update(Broadphase *self, GFC_List *bodies, GFC_List *static_shapes, Uint32 static_layer, const GFC_Rect *grid) {
+	Uint32 i, j, c;
+	BroadphaseProxy *a, *b;
+	GFC_Shape *shape;
+	CollisionPair *pair;
+	if (!self || !bodies) return;
+
+	self->pair_count = 0;
+	if (broadphase_build_proxies(self, bodies) != 0) return;
+	broadphase_sort_proxies(self);
+
+	// Sweep along the x axis for body pairs
+	for (i = 0; i < self->proxy_count; ++i) {
+		a = &self->proxies[i];
+		for (j = i + 1; j < self->proxy_count; ++j) {
+			b = &self->proxies[j];
+			if (b->bounds.x > a->bounds.x + a->bounds.w) break; // No later proxy can overlap a
+			if (a->body->sleeping && b->body->sleeping) continue;
+			if (!body_can_collide(a->body, b->body)) continue;
+			if (!broadphase_bounds_overlap(a->bounds, b->bounds)) continue;
+
+			pair = broadphase_push_pair(self);
+			if (!pair) return;
+			pair->a = a->body;
+			pair->b = b->body;
+			pair->shape = -1;
+		}
+	}
+
+	// Test awake bodies against the tile grid and the static shapes
+	c = gfc_list_count(static_shapes);
+	for (i = 0; i < self->proxy_count; ++i) {
+		a = &self->proxies[i];
+		if (a->body->sleeping) continue;
+		if (!(a->body->mask & static_layer)) continue;
+		if (a->body->inv_mass <= 0) continue; // Nothing to resolve, static shapes can't push it either
+
+		// The narrowphase looks the candidate tiles up in the grid itself
+		if (grid && broadphase_bounds_overlap(a->bounds, *grid)) {
+			pair = broadphase_push_pair(self);
+			if (!pair) return;
+			pair->a = a->body;
+			pair->b = NULL;
+			pair->shape = BROADPHASE_TILE_GRID;
+		}
+
+		for (j = 0; j < c; ++j) {
+			shape = gfc_list_get_nth(static_shapes, j);
+			if (!shape) continue;
+			if (!broadphase_bounds_overlap(a->bounds, collision_shape_bounds(*shape))) continue;
+
+			pair = broadphase_push_pair(self);
+			if (!pair) return;
+			pair->a = a->body;
+			pair->b = NULL;
+			pair->shape = j;
+		}
+	}
+}
+
+void broadphase_refresh(Broadphase *self, GFC_List *bodies) {
+	if (!self || !bodies) return;
+	if (broadphase_build_proxies(self, bodies) != 0) return;
+	broadphase_sort_proxies(self);
+}
+
+void broadphase_query(Broadphase *self, GFC_Rect bounds, void (*callback)(Body *body, void *data), void *data) {
+	Uint32 low, high, mid, i;
+	float left;
+	if (!self || !callback) return;
+
+	// Binary search for the first proxy that could reach the rect
+	left = bounds.x - self->max_width;
+	low = 0;
+	high = self->proxy_count;
+	while (low < high) {
+		mid = (low + high) / 2;
+		if (self->proxies[mid].bounds.x < left) low = mid + 1;
+		else high = mid;
+	}
+
+	for (i = low; i < self->proxy_count; ++i) {
+		if (self->proxies[i].bounds.x > bounds.x + bounds.w) break;
+		if (!broadphase_bounds_overlap(self->proxies[i].bounds, bounds)) continue;
+		callback(self->proxies[i].body, data);
+	}
+}
+
+void broadphase_remove_body(Broadphase *self, Body *body) {
+	Uint32 i;
+	if (!self || !body) return;
+	for (i = 0; i < self->proxy_count; ++i) {
+		if (self->proxies[i].body != body) continue;
+		memmove(&self->proxies[i], &self->proxies[i + 1], sizeof(BroadphaseProxy) * (self->proxy_count - i - 1));
+		self->proxy_count--;
+		return;
+	}
+}
+
+void broadphase_free(Broadphase *self) {
+	if (!self) return;
+	if (self->proxies) free(self->proxies);
+	if (self->pairs) free(self->pairs);
+	memset(self, 0, sizeof(Broadphase));
+}
@@ -5,6 +5,8 @@
 
 #include "bug.h"
 #include "camera.h"
+#include "world.h"
+#include "space.h"
 
 void bug_think(Entity *self) {
 
@@ -18,11 +20,9 @@ void bug_update(Entity *self) {
 		entity_free(self);
 		return;
 	}
-
-	gfc_vector2d_add(self->position, self->position, self->velocity);
 }
 
-Entity *bug_new_entity(GFC_Vector2D position, const char *filename) {
+Entity *bug_new_entity(GFC_Vector2D position, const char *filename, Entity *owner) {
 	Entity *self;
 	self = entity_new();
 	if (!self) {
@@ -36,6 +36,12 @@ Entity *bug_new_entity(GFC_Vector2D position, const char *filename) {
 	// Initialize and assign sprite
 	entity_configure_from_file(self, filename);
 
+	// Bugs move through the space, but never collide with whoever fired them
+	if (self->body) {
+		if (owner) self->body->owner = owner->body;
+		space_add_entity(world_get_active()->space, self);
+	}
+
 	// Assign functions
 	self->think = bug_think;
 	self->update = bug_update;
@@ -61,6 +61,30 @@ GFC_Vector2D main_camera_get_offset() {
 	return gfc_vector2d(-main_camera.position.x, -main_camera.position.y);
 }
 
+/**
+ * @brief compute the world space rect a camera can see
+ */
+static GFC_Rect camera_calc_view(Camera *self) {
+	GFC_Vector2D screen_res = gf2d_graphics_get_resolution();
+	float zoom = (self->zoom > 0) ? self->zoom : 1;
+
+	// Zooming in shows less of the world, zooming out shows more
+	screen_res.x /= zoom;
+	screen_res.y /= zoom;
+	return gfc_rect(self->position.x - screen_res.x / 2.0, self->position.y - screen_res.y / 2.0, screen_res.x, screen_res.y);
+}
+
+GFC_Rect main_camera_get_view() {
+	return camera_calc_view(&main_camera);
+}
+
+Uint8 main_camera_rect_visible(GFC_Rect rect) {
+	GFC_Rect view = camera_calc_view(&main_camera);
+	if (rect.x > view.x + view.w || rect.x + rect.w < view.x) return 0;
+	if (rect.y > view.y + view.h || rect.y + rect.h < view.y) return 0;
+	return 1;
+}
+
 Camera* camera_get_main() {
 	return &main_camera;
 }
@@ -83,17 +107,11 @@ void camera_update(Camera *self) {
 	// Lower bound zoom
 	if (self->zoom < 0.1) self->zoom = 0.1;
 
-	// Get screen resolution
-	GFC_Vector2D screen_res = gf2d_graphics_get_resolution();
-
 	// Update position
 	self->position = self->target->position;
 
 	// Update the rect
-	self->bounds.x = self->position.x - screen_res.x / 2.0;
-	self->bounds.y = self->position.y - screen_res.y / 2.0;
-	self->bounds.w = screen_res.x;
-	self->bounds.h = screen_res.y;
+	self->bounds = camera_calc_view(self);
 }
 
 GFC_Vector2D camera_get_zoom(Camera *self) {
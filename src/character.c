@@ -0,0 +1,139 @@
+#include "simple_logger.h"
+
+#include "character.h"
+#include "raycast.h"
+#include "space.h"
+
+CharacterController *character_new() {
+	CharacterController *controller;
+	controller = gfc_allocate_array(sizeof(CharacterController), 1);
+	if (!controller) {
+		slog("failed to allocate memory for character controller");
+		return NULL;
+	}
+	controller->slope_limit = CHARACTER_SLOPE_LIMIT;
+	controller->skin = CHARACTER_SKIN;
+	return controller;
+}
+
+void character_free(CharacterController *self) {
+	if (!self) return;
+	free(self);
+}
+
+void character_attach(Body *body, CharacterController *self) {
+	if (!body || !self) return;
+	if (body->controller && body->controller != self) character_free(body->controller);
+	body->controller = self;
+	body->inv_mass = 0;
+}
+
+/**
+ * @brief get the circle a body sweeps, in world space
+ * @return the radius, 0 if the body has nothing to sweep
+ */
+static float character_collider(Body *body, GFC_Vector2D *center) {
+	GFC_Rect bounds;
+	if (body->collider.type == ST_CIRCLE) {
+		*center = gfc_vector2d(body->position.x + body->collider.s.c.x, body->position.y + body->collider.s.c.y);
+		return body->collider.s.c.r;
+	}
+
+	// Other shapes are swept as the largest circle that fits in their bounds
+	bounds = collision_shape_bounds(body_world_collider(body));
+	*center = gfc_vector2d(bounds.x + bounds.w * 0.5, bounds.y + bounds.h * 0.5);
+	return MIN(bounds.w, bounds.h) * 0.5;
+}
+
+/**
+ * @brief check if a surface normal is flat enough to stand on
+ */
+static Uint8 character_is_ground(CharacterController *self, GFC_Vector2D normal) {
+	// Up is negative y, so ground normals point that way
+	return -normal.y >= cos(self->slope_limit * GFC_DEGTORAD);
+}
+
+void character_move(CharacterController *self, struct Space_S *space, Body *body, GFC_Vector2D motion) {
+	GFC_Vector2D center, start, direction;
+	RaycastHit hit;
+	TileData *tile;
+	float radius, distance, travel, into;
+	Sint32 ground_x = 0, ground_y = 0;
+	Uint32 i;
+	if (!self || !body) return;
+
+	self->grounded = 0;
+	self->on_one_way = 0;
+	self->ground_normal = gfc_vector2d(0, 0);
+	self->hit_count = 0;
+
+	radius = character_collider(body, &center);
+	start = center;
+	if (!space || radius <= 0) {
+		gfc_vector2d_add(body->position, body->position, motion);
+		return;
+	}
+
+	for (i = 0; i < CHARACTER_MAX_SLIDES; ++i) {
+		distance = gfc_vector2d_magnitude(motion);
+		if (distance <= GFC_EPSILON) break;
+		direction = gfc_vector2d(motion.x / distance, motion.y / distance);
+
+		if (!space_circle_cast(space, center, radius, direction, distance + self->skin, &hit)) {
+			gfc_vector2d_add(center, center, motion);
+			break;
+		}
+
+		// Stop short of the surface, keeping the skin gap
+		travel = MAX(hit.distance - self->skin, 0);
+		travel = MIN(travel, distance);
+		center.x += direction.x * travel;
+		center.y += direction.y * travel;
+		self->hit_count++;
+
+		if (character_is_ground(self, hit.normal)) {
+			self->grounded = 1;
+			self->ground_normal = hit.normal;
+			ground_x = hit.tile_x;
+			ground_y = hit.tile_y;
+		}
+
+		// Slide the rest of the motion along the surface
+		motion = gfc_vector2d(direction.x * (distance - travel), direction.y * (distance - travel));
+		into = gfc_vector2d_dot_product(motion, hit.normal);
+		if (into < 0) {
+			motion.x -= hit.normal.x * into;
+			motion.y -= hit.normal.y * into;
+		}
+
+		// Walls too steep to stand on can't be climbed by sliding up them
+		if (!character_is_ground(self, hit.normal) && hit.normal.y > -1 && motion.y < 0 && direction.y >= 0) {
+			motion.y = 0;
+		}
+
+		// Stop pushing into the surface so forces like gravity don't build up against it
+		into = gfc_vector2d_dot_product(body->velocity, hit.normal);
+		if (into < 0) {
+			body->velocity.x -= hit.normal.x * into;
+			body->velocity.y -= hit.normal.y * into;
+		}
+	}
+
+	// Look for ground just below the collider, unless the character is moving up
+	if (!self->grounded && body->velocity.y >= 0) {
+		if (space_circle_cast(space, center, radius, gfc_vector2d(0, 1), CHARACTER_GROUND_PROBE + self->skin, &hit)
+				&& character_is_ground(self, hit.normal)) {
+			self->grounded = 1;
+			self->ground_normal = hit.normal;
+			ground_x = hit.tile_x;
+			ground_y = hit.tile_y;
+		}
+	}
+	if (self->grounded) {
+		tile = space_get_solid_tile(space, ground_x, ground_y);
+		self->on_one_way = tile && tile->collision_type == TCT_ONE_WAY;
+	}
+
+	body->position.x += center.x - start.x;
+	body->position.y += center.y - start.y;
+}
@@ -1,3 +1,7 @@
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "simple_logger.h"
 
 #include "collision.h"
@@ -38,7 +42,7 @@ void collision_list_free(GFC_List *list) {
  */
 Collision *collision_new() {
 	// Create the new collision object
-	Collision *collision = gfc_allocate_array(sizeof(GFC_Vector2D), 1);
+	Collision *collision = gfc_allocate_array(sizeof(Collision), 1);
 
 	// Double checking collision
 	if (!collision) {
@@ -59,3 +63,310 @@ void collision_free(Collision *collision) {
 	if (!collision) return;
 	free(collision);
 }
+
+GFC_Rect collision_shape_bounds(GFC_Shape shape) {
+	switch (shape.type) {
+		case ST_CIRCLE:
+			return gfc_rect(shape.s.c.x - shape.s.c.r, shape.s.c.y - shape.s.c.r, shape.s.c.r * 2, shape.s.c.r * 2);
+		case ST_EDGE:
+			return gfc_rect(
+				MIN(shape.s.e.x1, shape.s.e.x2),
+				MIN(shape.s.e.y1, shape.s.e.y2),
+				fabs(shape.s.e.x2 - shape.s.e.x1),
+				fabs(shape.s.e.y2 - shape.s.e.y1));
+		case ST_RECT:
+		default:
+			return shape.s.r;
+	}
+}
+
+#ifdef __SSE2__
+
+#define COLLISION_SELECT(mask, a, b) _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b))
+
+Uint32 collision_circle_rect_batch(GFC_Circle circle, const CollisionRectBatch *rects, CollisionRectHits *hits) {
+	Uint32 i, result = 0;
+	__m128 cx, cy, r, r2, zero, one, neg_one;
+	__m128 left, top, right, bottom, px, py, dx, dy, d2, d, safe_d;
+	__m128 outside, inside, dist_l, dist_r, dist_t, dist_b, min_x, min_y, use_x, near_l, near_t;
+	__m128 nx, ny, depth, poc_x, poc_y;
+	if (!rects || !hits) return 0;
+
+	cx = _mm_set1_ps(circle.x);
+	cy = _mm_set1_ps(circle.y);
+	r = _mm_set1_ps(circle.r);
+	r2 = _mm_mul_ps(r, r);
+	zero = _mm_setzero_ps();
+	one = _mm_set1_ps(1);
+	neg_one = _mm_set1_ps(-1);
+
+	for (i = 0; i < rects->count; i += 4) {
+		left = _mm_loadu_ps(&rects->x[i]);
+		top = _mm_loadu_ps(&rects->y[i]);
+		right = _mm_add_ps(left, _mm_loadu_ps(&rects->w[i]));
+		bottom = _mm_add_ps(top, _mm_loadu_ps(&rects->h[i]));
+
+		// Closest point on each rect to the circle's center
+		px = _mm_min_ps(_mm_max_ps(cx, left), right);
+		py = _mm_min_ps(_mm_max_ps(cy, top), bottom);
+		dx = _mm_sub_ps(cx, px);
+		dy = _mm_sub_ps(cy, py);
+		d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		outside = _mm_and_ps(_mm_cmpgt_ps(d2, zero), _mm_cmplt_ps(d2, r2));
+		inside = _mm_cmpeq_ps(d2, zero);
+
+		// Center outside the rect, push out along the line to the closest point
+		d = _mm_sqrt_ps(d2);
+		safe_d = COLLISION_SELECT(outside, d, one);
+		nx = _mm_div_ps(dx, safe_d);
+		ny = _mm_div_ps(dy, safe_d);
+		depth = _mm_sub_ps(r, d);
+		poc_x = px;
+		poc_y = py;
+
+		// Center inside the rect, push out through the nearest edge
+		dist_l = _mm_sub_ps(cx, left);
+		dist_r = _mm_sub_ps(right, cx);
+		dist_t = _mm_sub_ps(cy, top);
+		dist_b = _mm_sub_ps(bottom, cy);
+		min_x = _mm_min_ps(dist_l, dist_r);
+		min_y = _mm_min_ps(dist_t, dist_b);
+		use_x = _mm_cmplt_ps(min_x, min_y);
+		near_l = _mm_cmplt_ps(dist_l, dist_r);
+		near_t = _mm_cmplt_ps(dist_t, dist_b);
+
+		nx = COLLISION_SELECT(inside, COLLISION_SELECT(use_x, COLLISION_SELECT(near_l, neg_one, one), zero), nx);
+		ny = COLLISION_SELECT(inside, COLLISION_SELECT(use_x, zero, COLLISION_SELECT(near_t, neg_one, one)), ny);
+		depth = COLLISION_SELECT(inside, _mm_add_ps(r, _mm_min_ps(min_x, min_y)), depth);
+		poc_x = COLLISION_SELECT(inside, COLLISION_SELECT(use_x, COLLISION_SELECT(near_l, left, right), cx), poc_x);
+		poc_y = COLLISION_SELECT(inside, COLLISION_SELECT(use_x, cy, COLLISION_SELECT(near_t, top, bottom)), poc_y);
+
+		_mm_storeu_ps(&hits->depth[i], depth);
+		_mm_storeu_ps(&hits->normal_x[i], nx);
+		_mm_storeu_ps(&hits->normal_y[i], ny);
+		_mm_storeu_ps(&hits->poc_x[i], poc_x);
+		_mm_storeu_ps(&hits->poc_y[i], poc_y);
+		result |= (Uint32)_mm_movemask_ps(_mm_or_ps(outside, inside)) << i;
+	}
+
+	// Drop the unused lanes of the last group
+	return result & ((1u << rects->count) - 1);
+}
+
+#else
+
+Uint32 collision_circle_rect_batch(GFC_Circle circle, const CollisionRectBatch *rects, CollisionRectHits *hits) {
+	Uint32 i, result = 0;
+	float px, py, dx, dy, d2, d, dist_l, dist_r, dist_t, dist_b;
+	if (!rects || !hits) return 0;
+
+	for (i = 0; i < rects->count; ++i) {
+		// Closest point on the rect to the circle's center
+		px = MIN(MAX(circle.x, rects->x[i]), rects->x[i] + rects->w[i]);
+		py = MIN(MAX(circle.y, rects->y[i]), rects->y[i] + rects->h[i]);
+		dx = circle.x - px;
+		dy = circle.y - py;
+		d2 = dx * dx + dy * dy;
+		if (d2 >= circle.r * circle.r) continue;
+		result |= 1u << i;
+
+		if (d2 > 0) {
+			// Center outside the rect, push out along the line to the closest point
+			d = sqrt(d2);
+			hits->normal_x[i] = dx / d;
+			hits->normal_y[i] = dy / d;
+			hits->depth[i] = circle.r - d;
+			hits->poc_x[i] = px;
+			hits->poc_y[i] = py;
+			continue;
+		}
+
+		// Center inside the rect, push out through the nearest edge
+		dist_l = circle.x - rects->x[i];
+		dist_r = rects->x[i] + rects->w[i] - circle.x;
+		dist_t = circle.y - rects->y[i];
+		dist_b = rects->y[i] + rects->h[i] - circle.y;
+		if (MIN(dist_l, dist_r) < MIN(dist_t, dist_b)) {
+			hits->normal_x[i] = dist_l < dist_r ? -1 : 1;
+			hits->normal_y[i] = 0;
+			hits->depth[i] = circle.r + MIN(dist_l, dist_r);
+			hits->poc_x[i] = dist_l < dist_r ? rects->x[i] : rects->x[i] + rects->w[i];
+			hits->poc_y[i] = circle.y;
+		} else {
+			hits->normal_x[i] = 0;
+			hits->normal_y[i] = dist_t < dist_b ? -1 : 1;
+			hits->depth[i] = circle.r + MIN(dist_t, dist_b);
+			hits->poc_x[i] = circle.x;
+			hits->poc_y[i] = dist_t < dist_b ? rects->y[i] : rects->y[i] + rects->h[i];
+		}
+	}
+	return result;
+}
+
+#endif
+
+Contact *contact_buffer_push(ContactBuffer *buffer) {
+	Contact *grown;
+	Uint32 capacity;
+	if (!buffer) return NULL;
+
+	// Grow the buffer geometrically when it is full
+	if (buffer->count >= buffer->capacity) {
+		capacity = buffer->capacity ? buffer->capacity * 2 : 64;
+		grown = realloc(buffer->contacts, sizeof(Contact) * capacity);
+		if (!grown) {
+			slog("failed to grow contact buffer to %i contacts", capacity);
+			return NULL;
+		}
+		buffer->contacts = grown;
+		buffer->capacity = capacity;
+	}
+
+	memset(&buffer->contacts[buffer->count], 0, sizeof(Contact));
+	return &buffer->contacts[buffer->count++];
+}
+
+void contact_buffer_append(ContactBuffer *dst, ContactBuffer *src) {
+	Uint32 i;
+	Contact *contact;
+	if (!dst || !src) return;
+	for (i = 0; i < src->count; ++i) {
+		contact = contact_buffer_push(dst);
+		if (!contact) return;
+		*contact = src->contacts[i];
+	}
+}
+
+void contact_buffer_clear(ContactBuffer *buffer) {
+	if (!buffer) return;
+	buffer->count = 0;
+}
+
+void contact_buffer_free(ContactBuffer *buffer) {
+	if (!buffer) return;
+	if (buffer->contacts) free(buffer->contacts);
+	memset(buffer, 0, sizeof(ContactBuffer));
+}
+
+Uint64 contact_key(Contact *contact) {
+	Uint32 a, b;
+	if (!contact || !contact->a) return 0;
+	a = contact->a->id;
+
+	// Static shapes get the top bit so they never collide with body ids
+	if (!contact->b) return ((Uint64)a << 32) | (0x80000000u | (Uint32)contact->shape);
+
+	b = contact->b->id;
+	if (a > b) return ((Uint64)b << 32) | a;
+	return ((Uint64)a << 32) | b;
+}
+
+/**
+ * @brief hash a contact key into a slot index
+ */
+static Uint32 contact_cache_slot(Uint64 key, Uint32 capacity) {
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	return (Uint32)key & (capacity - 1);
+}
+
+/**
+ * @brief move every live entry into a new table of the given capacity
+ * @param cache the cache being resized
+ * @param capacity the new capacity, must be a power of two
+ * @return 0 on success, -1 if memory could not be allocated
+ */
+static int contact_cache_rehash(ContactCache *cache, Uint32 capacity) {
+	Uint32 i, slot;
+	ContactCacheEntry *old = cache->entries;
+	Uint32 old_capacity = cache->capacity;
+	ContactCacheEntry *entries = gfc_allocate_array(sizeof(ContactCacheEntry), capacity);
+	if (!entries) {
+		slog("failed to grow contact cache to %i entries", capacity);
+		return -1;
+	}
+
+	cache->entries = entries;
+	cache->capacity = capacity;
+	cache->count = 0;
+	for (i = 0; i < old_capacity; ++i) {
+		if (!old[i].key) continue;
+		slot = contact_cache_slot(old[i].key, capacity);
+		while (entries[slot].key) slot = (slot + 1) & (capacity - 1);
+		entries[slot] = old[i];
+		cache->count++;
+	}
+	if (old) free(old);
+	return 0;
+}
+
+ContactCacheEntry *contact_cache_get(ContactCache *cache, Uint64 key, Uint8 create) {
+	Uint32 slot;
+	if (!cache || !key) return NULL;
+
+	// Keep the table at most half full so probes stay short
+	if (create && (cache->count + 1) * 2 > cache->capacity) {
+		if (contact_cache_rehash(cache, cache->capacity ? cache->capacity * 2 : 64) != 0) return NULL;
+	}
+	if (!cache->capacity) return NULL;
+
+	slot = contact_cache_slot(key, cache->capacity);
+	while (cache->entries[slot].key) {
+		if (cache->entries[slot].key == key) {
+			cache->entries[slot].stamp = cache->stamp;
+			return &cache->entries[slot];
+		}
+		slot = (slot + 1) & (cache->capacity - 1);
+	}
+	if (!create) return NULL;
+
+	cache->entries[slot].key = key;
+	cache->entries[slot].impulse = 0;
+	cache->entries[slot].stamp = cache->stamp;
+	cache->count++;
+	return &cache->entries[slot];
+}
+
+/**
+ * @brief empty a slot, shifting later entries of its probe chain back so lookups still find them
+ * @param cache the cache being modified
+ * @param slot the slot to be emptied
+ */
+static void contact_cache_remove_slot(ContactCache *cache, Uint32 slot) {
+	Uint32 next, home;
+	Uint32 mask = cache->capacity - 1;
+	next = slot;
+	for (;;) {
+		next = (next + 1) & mask;
+		if (!cache->entries[next].key) break;
+
+		// Entries whose home lies cyclically in (slot, next] are already reachable
+		home = contact_cache_slot(cache->entries[next].key, cache->capacity);
+		if (slot <= next ? (slot < home && home <= next) : (slot < home || home <= next)) continue;
+
+		cache->entries[slot] = cache->entries[next];
+		slot = next;
+	}
+	cache->entries[slot].key = 0;
+	cache->count--;
+}
+
+void contact_cache_prune(ContactCache *cache) {
+	Uint32 i;
+	if (!cache || !cache->capacity) return;
+	for (i = 0; i < cache->capacity; ) {
+		if (cache->entries[i].key && cache->entries[i].stamp != cache->stamp) {
+			contact_cache_remove_slot(cache, i); // Recheck the slot, another entry may have shifted into it
+			continue;
+		}
+		i++;
+	}
+	cache->stamp++;
+}
+
+void contact_cache_free(ContactCache *cache) {
+	if (!cache) return;
+	if (cache->entries) free(cache->entries);
+	memset(cache, 0, sizeof(ContactCache));
+}
@@ -5,10 +5,13 @@
 #include "gfc_config.h"
 
 #include "gf2d_graphics.h"
-#include "gf2d_draw.h"
+#include "gf2d_render_queue.h"
+#include "gf2d_debug_draw.h"
 
 #include "entity.h"
 #include "camera.h"
+#include "character.h"
+#include "space.h"
 
 Uint8	DRAW_CENTER = 0;
 Uint8	DRAW_BOUNDS = 0;
@@ -92,12 +95,28 @@ void entity_system_think_all() {
  */
 void entity_system_presync_all() {
 	int i;
+	Uint8 moved;
 	Entity *ent;
 	for (i = 0; i < entity_system.entity_max; i++) {
 		// Check if the entity slot we're looking at is inuse and has an update function
 		ent = &entity_system.entity_list[i];
 		if (ent->_inuse && ent->body) {
 			slog("entity body updated");
+
+			// A body the entity moved may have entered or left a trigger
+			moved = ent->position.x != ent->body->position.x || ent->position.y != ent->body->position.y;
+			if (moved && ent->body->space) ent->body->space->triggers_dirty = 1;
+
+			// Wake the body if the entity has written new motion or moved it
+			if (ent->body->sleeping
+					&& (moved
+					|| ent->velocity.x != ent->body->velocity.x
+					|| ent->velocity.y != ent->body->velocity.y
+					|| ent->acceleration.x != 0
+					|| ent->acceleration.y != 0)) {
+				body_wake(ent->body);
+			}
+
 			gfc_vector2d_copy(ent->body->position, ent->position);
 			gfc_vector2d_copy(ent->body->velocity, ent->velocity);
 			gfc_vector2d_copy(ent->body->acceleration, ent->acceleration);
@@ -120,7 +139,7 @@ void entity_system_postsync_all() {
 			slog("entity state updated");
 			gfc_vector2d_copy(ent->position, ent->body->position);
 			gfc_vector2d_copy(ent->velocity, ent->body->velocity);
-			gfc_vector2d_copy(ent->velocity, ent->body->acceleration);		
+			gfc_vector2d_copy(ent->acceleration, ent->body->acceleration);
 		}
 	}
 
@@ -183,10 +202,34 @@ void entity_free(Entity *ent) {
 	entity_system.active_entities--;
 }
 
+/**
+ * @brief get the world space box an entity draws into
+ */
+static GFC_Rect entity_get_draw_bounds(Entity *self) {
+	GFC_Rect bounds = gfc_rect(
+		self->position.x - self->sprite_offset.x,
+		self->position.y - self->sprite_offset.y,
+		self->sprite->frame_w,
+		self->sprite->frame_h);
+
+	// The debug collider can reach past the sprite
+	if (DRAW_BOUNDS) {
+		float left = MIN(bounds.x, self->position.x + self->collider.x - self->collider.r);
+		float top = MIN(bounds.y, self->position.y + self->collider.y - self->collider.r);
+		float right = MAX(bounds.x + bounds.w, self->position.x + self->collider.x + self->collider.r);
+		float bottom = MAX(bounds.y + bounds.h, self->position.y + self->collider.y + self->collider.r);
+		bounds = gfc_rect(left, top, right - left, bottom - top);
+	}
+	return bounds;
+}
+
 void entity_draw(Entity *self) {
 	// Verify pointers
 	if (!self || !self->sprite) return;
 
+	// Skip entities that are entirely off screen
+	if (!main_camera_rect_visible(entity_get_draw_bounds(self))) return;
+
 	// Get a pointer to the main camera
 	Camera* main_camera = camera_get_main();
 
@@ -204,8 +247,8 @@ void entity_draw(Entity *self) {
 
 	GFC_Vector2D center = self->sprite_offset;
 
-	// Draw the sprite
-	gf2d_sprite_draw(
+	// Queue the sprite, y sorted so entities further down the screen overlap the ones above them
+	gf2d_render_queue_sprite(
 		self->sprite,
 		draw_pos,
 		&scale,
@@ -213,15 +256,18 @@ void entity_draw(Entity *self) {
 		NULL,
 		NULL,
 		NULL,
-		(Uint32)self->frame);
+		NULL,
+		(Uint32)self->frame,
+		RL_ENTITIES,
+		self->position.y);
 
 	// Draw the point
-	if (DRAW_CENTER) gf2d_draw_circle(draw_pos, 4, GFC_COLOR_LIGHTGREEN);
+	if (DRAW_CENTER) gf2d_debug_draw_circle(draw_pos, 4, GFC_COLOR_LIGHTGREEN);
 
 	if (DRAW_BOUNDS) {
 		GFC_Vector2D circle_center = gfc_vector2d(self->collider.x + self->position.x, self->collider.y + self->position.y);
 		GFC_Vector2D collider_drawpos = main_camera_calc_drawpos(circle_center);
-		gf2d_draw_circle(collider_drawpos, self->collider.r * scale.x, GFC_COLOR_RED);
+		gf2d_debug_draw_circle(collider_drawpos, self->collider.r * scale.x, GFC_COLOR_RED);
 	}
 }	
 
@@ -232,6 +278,40 @@ void entity_configure_from_file(Entity *self, const char *filename) {
 	sj_free(json);
 }
 
+/**
+ * @brief read a set of collision layers from a def file
+ * @param json the json value, either an array of layer names or a raw bit mask
+ * @param layers receives the layers if the value is present
+ */
+static void entity_configure_layers(SJson *json, Uint32 *layers) {
+	int i, c, value = 0;
+	if (!json || !layers) return;
+	if (sj_is_array(json)) {
+		*layers = BL_NONE;
+		c = sj_array_get_count(json);
+		for (i = 0; i < c; ++i) {
+			*layers |= body_layer_from_name(sj_get_string_value(sj_array_get_nth(json, i)));
+		}
+	} else if (sj_get_integer_value(json, &value)) {
+		*layers = (Uint32)value;
+	}
+}
+
+/**
+ * @brief attach a character controller to a body if the json asks for one
+ * @param json the controller's config object, {} for the defaults
+ * @param body the body the controller moves
+ */
+static void entity_configure_controller(SJson *json, Body *body) {
+	CharacterController *controller;
+	if (!json || !body) return;
+	controller = character_new();
+	if (!controller) return;
+	sj_object_get_float(json, "slopeLimit", &controller->slope_limit);
+	sj_object_get_float(json, "skin", &controller->skin);
+	character_attach(body, controller);
+}
+
 void entity_configure(Entity *self, SJson *json) {
 	const char *sprite = NULL;
 	if ((!self)||(!json)) return;
@@ -264,6 +344,16 @@ void entity_configure(Entity *self, SJson *json) {
 	// Load the physics body
 	Body *body = body_new();
 	self->body = body;
+	if (body) {
+		float mass = 1;
+		body->entity = self;
+		body->collider = gfc_shape_from_circle(self->collider);
+		sj_object_get_float(json, "mass", &mass);
+		body_set_mass(body, mass);
+		entity_configure_layers(sj_object_get_value(json, "collisionLayer"), &body->layer);
+		entity_configure_layers(sj_object_get_value(json, "collisionMask"), &body->mask);
+		entity_configure_controller(sj_object_get_value(json, "characterController"), body);
+	}
 
 	// Load the entity name
 	const char *name = NULL;
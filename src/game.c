@@ -3,6 +3,10 @@
 
 #include "gf2d_graphics.h"
 #include "gf2d_sprite.h"
+#include "gf2d_batch.h"
+#include "gf2d_render_queue.h"
+#include "gf2d_debug_draw.h"
+#include "gf2d_atlas.h"
 
 #include "gfc_input.h"
 #include "gfc_string.h"
@@ -12,6 +16,8 @@
 #include "camera.h"
 #include "world.h"
 #include "space.h"
+#include "job.h"
+#include "narrowphase.h"
 
 int parse_args(int argc, char * argv[]) {
 	if (argc < 2) return 0;
@@ -57,6 +63,11 @@ int main(int argc, char * argv[])
         0);
     gf2d_graphics_set_frame_delay(16);
     gf2d_sprite_init(1024);
+    gf2d_sprite_set_memory_budget(128 * 1024 * 1024);
+    gf2d_atlas_init(2048,4,512);
+    gf2d_batch_init(4096);
+    gf2d_render_queue_init(4096);
+    gf2d_debug_draw_init(1024);
 	
     // Parse Args
     int parse_status = parse_args(argc, argv);
@@ -65,6 +76,8 @@ int main(int argc, char * argv[])
     // inserting code to initialize systems
     gfc_input_init("./config/input.cfg");
     entity_system_init(1024);
+    job_system_init(0);
+    narrowphase_init();
 
     SDL_ShowCursor(SDL_DISABLE);
     
@@ -94,6 +107,9 @@ int main(int argc, char * argv[])
         SDL_GetMouseState(&mx,&my);
         mf+=0.1;
         if (mf >= 16.0)mf = 0;
+
+        // Upload any sprites that finished loading in the background, a few milliseconds at most
+        gf2d_sprite_async_update(4);
         
         gf2d_graphics_clear_screen();// clears drawing buffers
 	
@@ -119,7 +135,7 @@ int main(int argc, char * argv[])
 	    entity_system_draw_all();
 
             //UI elements last
-            gf2d_sprite_draw(
+            gf2d_render_queue_sprite(
                 mouse,
                 gfc_vector2d(mx,my),
                 NULL,
@@ -127,7 +143,10 @@ int main(int argc, char * argv[])
                 NULL,
                 NULL,
                 &mouseGFC_Color,
-                (int)mf);
+                NULL,
+                (int)mf,
+                RL_UI,
+                0);
 
         gf2d_graphics_next_frame();// render current draw frame and skip to the next frame
         
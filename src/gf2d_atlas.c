@@ -0,0 +1,295 @@
+#include <stdlib.h>
+
+#include "simple_logger.h"
+
+#include "gf2d_graphics.h"
+#include "gf2d_atlas.h"
+
+typedef struct
+{
+    int x;      /**<left edge of this segment of the skyline*/
+    int y;      /**<height of the skyline along the segment*/
+    int w;      /**<width of the segment*/
+}SkylineNode;
+
+typedef struct
+{
+    SDL_Texture *texture;
+    SkylineNode *nodes;     /**<the skyline, left to right*/
+    Uint32 node_count;
+    Uint32 image_count;     /**<images still packed into the page, it is emptied once this reaches zero*/
+}AtlasPage;
+
+typedef struct
+{
+    Uint32 page_size;
+    Uint32 max_pages;
+    Uint32 max_image_size;
+    Uint32 page_count;
+    AtlasPage *pages;
+}Atlas;
+
+static Atlas gf2d_atlas = {0};
+
+void gf2d_atlas_close()
+{
+    Uint32 i;
+    for (i = 0;i < gf2d_atlas.page_count;i++)
+    {
+        if (gf2d_atlas.pages[i].texture)SDL_DestroyTexture(gf2d_atlas.pages[i].texture);
+        if (gf2d_atlas.pages[i].nodes)free(gf2d_atlas.pages[i].nodes);
+    }
+    if (gf2d_atlas.pages)free(gf2d_atlas.pages);
+    memset(&gf2d_atlas,0,sizeof(Atlas));
+    slog("texture atlas closed");
+}
+
+void gf2d_atlas_init(Uint32 page_size,Uint32 max_pages,Uint32 max_image_size)
+{
+    if ((!page_size)||(!max_pages))
+    {
+        slog("cannot intialize a texture atlas with no pages!");
+        return;
+    }
+    gf2d_atlas.pages = (AtlasPage *)gfc_allocate_array(sizeof(AtlasPage),max_pages);
+    if (!gf2d_atlas.pages)
+    {
+        slog("failed to allocate %i atlas pages",max_pages);
+        return;
+    }
+    gf2d_atlas.page_size = page_size;
+    gf2d_atlas.max_pages = max_pages;
+    gf2d_atlas.max_image_size = MIN(max_image_size,page_size);
+    slog("texture atlas initialized");
+    atexit(gf2d_atlas_close);
+}
+
+Uint32 gf2d_atlas_get_page_count()
+{
+    return gf2d_atlas.page_count;
+}
+
+Uint64 gf2d_atlas_get_bytes()
+{
+    return (Uint64)gf2d_atlas.page_count * gf2d_atlas.page_size * gf2d_atlas.page_size * 4;
+}
+
+/**
+ * @brief set a page's skyline back to a single segment along its bottom
+ */
+static void gf2d_atlas_reset_page(AtlasPage *page)
+{
+    page->nodes[0].x = 0;
+    page->nodes[0].y = 0;
+    page->nodes[0].w = gf2d_atlas.page_size;
+    page->node_count = 1;
+}
+
+/**
+ * @brief create a new empty page
+ * @return NULL if out of pages or memory
+ */
+static AtlasPage *gf2d_atlas_new_page()
+{
+    AtlasPage *page;
+    if (gf2d_atlas.page_count >= gf2d_atlas.max_pages)return NULL;
+    page = &gf2d_atlas.pages[gf2d_atlas.page_count];
+    // the skyline never has more segments than the page has columns, plus one while placing
+    page->nodes = (SkylineNode *)gfc_allocate_array(sizeof(SkylineNode),gf2d_atlas.page_size + 1);
+    if (!page->nodes)return NULL;
+    page->texture = SDL_CreateTexture(
+        gf2d_graphics_get_renderer(),
+        SDL_PIXELFORMAT_ARGB8888,
+        SDL_TEXTUREACCESS_STATIC,
+        gf2d_atlas.page_size,
+        gf2d_atlas.page_size);
+    if (!page->texture)
+    {
+        slog("failed to create atlas page: %s",SDL_GetError());
+        free(page->nodes);
+        page->nodes = NULL;
+        return NULL;
+    }
+    SDL_SetTextureBlendMode(page->texture,SDL_BLENDMODE_BLEND);
+    gf2d_atlas_reset_page(page);
+    gf2d_atlas.page_count++;
+    slog("created atlas page %i",gf2d_atlas.page_count - 1);
+    return page;
+}
+
+/**
+ * @brief find how high a rect would sit if its left edge was placed at a skyline node
+ * @return the y the rect would be placed at, -1 if it does not fit there
+ */
+static int gf2d_atlas_fit(AtlasPage *page,Uint32 index,int w,int h)
+{
+    int y,width_left;
+    if (page->nodes[index].x + w > (int)gf2d_atlas.page_size)return -1;
+    y = page->nodes[index].y;
+    width_left = w;
+    while (width_left > 0)
+    {
+        if (index >= page->node_count)return -1;
+        y = MAX(y,page->nodes[index].y);
+        if (y + h > (int)gf2d_atlas.page_size)return -1;
+        width_left -= page->nodes[index].w;
+        index++;
+    }
+    return y;
+}
+
+/**
+ * @brief merge neighbouring skyline segments at the same height
+ */
+static void gf2d_atlas_merge(AtlasPage *page)
+{
+    Uint32 i;
+    for (i = 0;i + 1 < page->node_count;)
+    {
+        if (page->nodes[i].y != page->nodes[i + 1].y)
+        {
+            i++;
+            continue;
+        }
+        page->nodes[i].w += page->nodes[i + 1].w;
+        memmove(&page->nodes[i + 1],&page->nodes[i + 2],sizeof(SkylineNode) * (page->node_count - i - 2));
+        page->node_count--;
+    }
+}
+
+/**
+ * @brief raise the skyline under a newly placed rect
+ */
+static void gf2d_atlas_place(AtlasPage *page,Uint32 index,int x,int y,int w,int h)
+{
+    Uint32 i;
+    int shrink;
+
+    // the new segment covers the rect's top
+    memmove(&page->nodes[index + 1],&page->nodes[index],sizeof(SkylineNode) * (page->node_count - index));
+    page->nodes[index].x = x;
+    page->nodes[index].y = y + h;
+    page->nodes[index].w = w;
+    page->node_count++;
+
+    // cut back or remove the segments it now covers
+    for (i = index + 1;i < page->node_count;)
+    {
+        if (page->nodes[i].x >= page->nodes[i - 1].x + page->nodes[i - 1].w)break;
+        shrink = page->nodes[i - 1].x + page->nodes[i - 1].w - page->nodes[i].x;
+        page->nodes[i].x += shrink;
+        page->nodes[i].w -= shrink;
+        if (page->nodes[i].w > 0)break;
+        memmove(&page->nodes[i],&page->nodes[i + 1],sizeof(SkylineNode) * (page->node_count - i - 1));
+        page->node_count--;
+    }
+    gf2d_atlas_merge(page);
+}
+
+/**
+ * @brief find the lowest spot on a page for a rect, bottom left heuristic
+ * @return 1 if the rect fits, with its position and skyline node filled in
+ */
+static Uint8 gf2d_atlas_find(AtlasPage *page,int w,int h,Uint32 *index,int *x,int *y)
+{
+    Uint32 i;
+    int fit,best_y = -1,best_w = 0;
+    for (i = 0;i < page->node_count;i++)
+    {
+        fit = gf2d_atlas_fit(page,i,w,h);
+        if (fit < 0)continue;
+        if ((best_y < 0)||(fit + h < best_y)||((fit + h == best_y)&&(page->nodes[i].w < best_w)))
+        {
+            best_y = fit + h;
+            best_w = page->nodes[i].w;
+            *index = i;
+            *x = page->nodes[i].x;
+            *y = fit;
+        }
+    }
+    return best_y >= 0;
+}
+
+Uint8 gf2d_atlas_add(SDL_Surface *surface,SDL_Texture **texture,SDL_Rect *rect,Uint32 *page)
+{
+    Uint32 i,index = 0;
+    int x = 0,y = 0,w,h;
+    AtlasPage *target = NULL;
+    SDL_Surface *converted;
+    if ((!surface)||(!texture)||(!rect)||(!page))return 0;
+    if (!gf2d_atlas.pages)return 0;
+    if ((surface->w > (int)gf2d_atlas.max_image_size)||(surface->h > (int)gf2d_atlas.max_image_size))return 0;
+    w = surface->w + GF2D_ATLAS_PADDING;
+    h = surface->h + GF2D_ATLAS_PADDING;
+
+    for (i = 0;i < gf2d_atlas.page_count;i++)
+    {
+        if (gf2d_atlas_find(&gf2d_atlas.pages[i],w,h,&index,&x,&y))
+        {
+            target = &gf2d_atlas.pages[i];
+            break;
+        }
+    }
+    if (!target)
+    {
+        target = gf2d_atlas_new_page();
+        if (!target)return 0;
+        i = gf2d_atlas.page_count - 1;
+        if (!gf2d_atlas_find(target,w,h,&index,&x,&y))return 0;
+    }
+
+    // pages are always ARGB8888, so convert the pixels to match before uploading
+    converted = SDL_ConvertSurfaceFormat(surface,SDL_PIXELFORMAT_ARGB8888,0);
+    if (!converted)
+    {
+        slog("failed to convert image for the atlas: %s",SDL_GetError());
+        return 0;
+    }
+    rect->x = x;
+    rect->y = y;
+    rect->w = surface->w;
+    rect->h = surface->h;
+    if (SDL_UpdateTexture(target->texture,rect,converted->pixels,converted->pitch) != 0)
+    {
+        slog("failed to upload image to atlas page %i: %s",i,SDL_GetError());
+        SDL_FreeSurface(converted);
+        return 0;
+    }
+    SDL_FreeSurface(converted);
+    gf2d_atlas_place(target,index,x,y,w,h);
+    target->image_count++;
+    *texture = target->texture;
+    *page = i;
+    return 1;
+}
+
+void gf2d_atlas_remove(Uint32 page,SDL_Rect *rect)
+{
+    AtlasPage *target;
+    Uint32 i;
+    if ((!rect)||(page >= gf2d_atlas.page_count))return;
+    target = &gf2d_atlas.pages[page];
+    if (!target->image_count)return;
+    target->image_count--;
+    if (!target->image_count)
+    {
+        // nothing is left on the page, so all of it can be packed again
+        gf2d_atlas_reset_page(target);
+        return;
+    }
+
+    // the skyline only tracks tops, so only an image with nothing packed on top of it gives its space back
+    for (i = 0;i < target->node_count;i++)
+    {
+        if (target->nodes[i].x != rect->x)continue;
+        if ((target->nodes[i].w == rect->w + GF2D_ATLAS_PADDING)&&
+            (target->nodes[i].y == rect->y + rect->h + GF2D_ATLAS_PADDING))
+        {
+            target->nodes[i].y = rect->y;
+            gf2d_atlas_merge(target);
+        }
+        return;
+    }
+}
+
+/*eol@eof*/
@@ -0,0 +1,194 @@
+#include <SDL.h>
+#include <stdlib.h>
+
+#include "simple_logger.h"
+
+#include "gf2d_graphics.h"
+#include "gf2d_batch.h"
+
+typedef struct
+{
+    Uint32 max_quads;
+    Uint32 quad_count;
+    SDL_Vertex *vertices;   /**<four vertices per quad*/
+    int *indices;           /**<two triangles per quad, built once at init*/
+    SDL_Texture *texture;   /**<the texture of the quads being collected*/
+    float texture_w;        /**<size of the texture, to turn pixel rects into texture coordinates*/
+    float texture_h;
+    Uint32 draw_calls;
+}SpriteBatch;
+
+static SpriteBatch sprite_batch = {0};
+
+void gf2d_batch_close()
+{
+    if (sprite_batch.vertices)free(sprite_batch.vertices);
+    if (sprite_batch.indices)free(sprite_batch.indices);
+    memset(&sprite_batch,0,sizeof(SpriteBatch));
+    slog("sprite batch closed");
+}
+
+void gf2d_batch_init(Uint32 max_quads)
+{
+    Uint32 i;
+    if (sprite_batch.vertices)return;
+    if (!max_quads)
+    {
+        slog("cannot intialize a sprite batch for Zero quads!");
+        return;
+    }
+    sprite_batch.vertices = (SDL_Vertex *)gfc_allocate_array(sizeof(SDL_Vertex),max_quads * 4);
+    sprite_batch.indices = (int *)gfc_allocate_array(sizeof(int),max_quads * 6);
+    if ((!sprite_batch.vertices)||(!sprite_batch.indices))
+    {
+        slog("failed to allocate sprite batch for %i quads",max_quads);
+        gf2d_batch_close();
+        return;
+    }
+    for (i = 0;i < max_quads;i++)
+    {
+        sprite_batch.indices[i*6 + 0] = i*4 + 0;
+        sprite_batch.indices[i*6 + 1] = i*4 + 1;
+        sprite_batch.indices[i*6 + 2] = i*4 + 2;
+        sprite_batch.indices[i*6 + 3] = i*4 + 0;
+        sprite_batch.indices[i*6 + 4] = i*4 + 2;
+        sprite_batch.indices[i*6 + 5] = i*4 + 3;
+    }
+    sprite_batch.max_quads = max_quads;
+    slog("sprite batch initialized");
+    atexit(gf2d_batch_close);
+}
+
+void gf2d_batch_flush()
+{
+    if (!sprite_batch.quad_count)return;
+#if GF2D_BATCH_GEOMETRY
+    if (SDL_RenderGeometry(
+        gf2d_graphics_get_renderer(),
+        sprite_batch.texture,
+        sprite_batch.vertices,
+        sprite_batch.quad_count * 4,
+        sprite_batch.indices,
+        sprite_batch.quad_count * 6) != 0)
+    {
+        slog("failed to render sprite batch: %s",SDL_GetError());
+    }
+    sprite_batch.draw_calls++;
+#endif
+    sprite_batch.quad_count = 0;
+}
+
+#if GF2D_BATCH_GEOMETRY
+
+void gf2d_batch_quad(
+    SDL_Texture *texture,
+    const SDL_Rect *src,
+    const SDL_FPoint corners[4],
+    SDL_Color color,
+    SDL_RendererFlip flip)
+{
+    int w,h,i;
+    float u0,v0,u1,v1,swap;
+    SDL_Vertex *quad;
+    if ((!texture)||(!src)||(!corners))return;
+    if (!sprite_batch.vertices)
+    {
+        gf2d_batch_init(GF2D_BATCH_DEFAULT_QUADS);
+        if (!sprite_batch.vertices)return;
+    }
+    if ((texture != sprite_batch.texture)||(sprite_batch.quad_count >= sprite_batch.max_quads))
+    {
+        gf2d_batch_flush();
+    }
+    if (texture != sprite_batch.texture)
+    {
+        if (SDL_QueryTexture(texture,NULL,NULL,&w,&h) != 0)
+        {
+            slog("failed to query texture for sprite batch: %s",SDL_GetError());
+            return;
+        }
+        sprite_batch.texture = texture;
+        sprite_batch.texture_w = w;
+        sprite_batch.texture_h = h;
+    }
+
+    u0 = src->x / sprite_batch.texture_w;
+    v0 = src->y / sprite_batch.texture_h;
+    u1 = (src->x + src->w) / sprite_batch.texture_w;
+    v1 = (src->y + src->h) / sprite_batch.texture_h;
+    if (flip & SDL_FLIP_HORIZONTAL)
+    {
+        swap = u0;
+        u0 = u1;
+        u1 = swap;
+    }
+    if (flip & SDL_FLIP_VERTICAL)
+    {
+        swap = v0;
+        v0 = v1;
+        v1 = swap;
+    }
+
+    quad = &sprite_batch.vertices[sprite_batch.quad_count * 4];
+    for (i = 0;i < 4;i++)
+    {
+        quad[i].position = corners[i];
+        quad[i].color = color;
+    }
+    quad[0].tex_coord.x = u0;
+    quad[0].tex_coord.y = v0;
+    quad[1].tex_coord.x = u1;
+    quad[1].tex_coord.y = v0;
+    quad[2].tex_coord.x = u1;
+    quad[2].tex_coord.y = v1;
+    quad[3].tex_coord.x = u0;
+    quad[3].tex_coord.y = v1;
+    sprite_batch.quad_count++;
+}
+
+#else
+
+void gf2d_batch_quad(
+    SDL_Texture *texture,
+    const SDL_Rect *src,
+    const SDL_FPoint corners[4],
+    SDL_Color color,
+    SDL_RendererFlip flip)
+{
+    SDL_FRect target;
+    SDL_FPoint pivot = {0,0};
+    double angle;
+    if ((!texture)||(!src)||(!corners))return;
+    // rebuild the unrotated rect around the quad's center and draw it on its own
+    target.w = sqrt((corners[1].x - corners[0].x)*(corners[1].x - corners[0].x) + (corners[1].y - corners[0].y)*(corners[1].y - corners[0].y));
+    target.h = sqrt((corners[3].x - corners[0].x)*(corners[3].x - corners[0].x) + (corners[3].y - corners[0].y)*(corners[3].y - corners[0].y));
+    target.x = (corners[0].x + corners[2].x) * 0.5 - target.w * 0.5;
+    target.y = (corners[0].y + corners[2].y) * 0.5 - target.h * 0.5;
+    pivot.x = target.w * 0.5;
+    pivot.y = target.h * 0.5;
+    angle = atan2(corners[1].y - corners[0].y,corners[1].x - corners[0].x) * GFC_RADTODEG;
+    SDL_SetTextureColorMod(texture,color.r,color.g,color.b);
+    SDL_SetTextureAlphaMod(texture,color.a);
+    SDL_RenderCopyExF(gf2d_graphics_get_renderer(),texture,src,&target,angle,&pivot,flip);
+    SDL_SetTextureColorMod(texture,255,255,255);
+    SDL_SetTextureAlphaMod(texture,255);
+    sprite_batch.draw_calls++;
+}
+
+#endif
+
+void gf2d_batch_release_texture(SDL_Texture *texture)
+{
+    if ((!texture)||(texture != sprite_batch.texture))return;
+    gf2d_batch_flush();
+    sprite_batch.texture = NULL;
+}
+
+Uint32 gf2d_batch_get_draw_calls()
+{
+    Uint32 draw_calls = sprite_batch.draw_calls;
+    sprite_batch.draw_calls = 0;
+    return draw_calls;
+}
+
+/*eol@eof*/
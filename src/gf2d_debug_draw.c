@@ -0,0 +1,189 @@
+#include <stdlib.h>
+
+#include "simple_logger.h"
+
+#include "gf2d_graphics.h"
+#include "gf2d_draw.h"
+#include "gf2d_batch.h"
+#include "gf2d_debug_draw.h"
+
+#if GF2D_DEBUG_DRAW
+
+typedef struct
+{
+    SDL_Color color;
+    SDL_Point *points;          /**<single points, circles included*/
+    Uint32 point_count;
+    Uint32 point_capacity;
+    SDL_Point *line_points;     /**<the points of every line strip, back to back*/
+    Uint32 line_point_count;
+    Uint32 line_point_capacity;
+    Uint32 *strips;             /**<the index of each strip's first point in line_points*/
+    Uint32 strip_count;
+    Uint32 strip_capacity;
+    SDL_Rect *rects;
+    Uint32 rect_count;
+    Uint32 rect_capacity;
+}DebugDrawGroup;
+
+typedef struct
+{
+    DebugDrawGroup groups[GF2D_DEBUG_DRAW_COLORS];
+    Uint32 group_count;         /**<groups with a color this frame, the arrays of the rest are kept for reuse*/
+    Uint32 initial_capacity;
+}DebugDraw;
+
+static DebugDraw gf2d_debug_draw = {0};
+
+void gf2d_debug_draw_close()
+{
+    Uint32 i;
+    for (i = 0;i < GF2D_DEBUG_DRAW_COLORS;i++)
+    {
+        if (gf2d_debug_draw.groups[i].points)free(gf2d_debug_draw.groups[i].points);
+        if (gf2d_debug_draw.groups[i].line_points)free(gf2d_debug_draw.groups[i].line_points);
+        if (gf2d_debug_draw.groups[i].strips)free(gf2d_debug_draw.groups[i].strips);
+        if (gf2d_debug_draw.groups[i].rects)free(gf2d_debug_draw.groups[i].rects);
+    }
+    memset(&gf2d_debug_draw,0,sizeof(DebugDraw));
+    slog("debug draw closed");
+}
+
+void gf2d_debug_draw_init(Uint32 max_primitives)
+{
+    gf2d_debug_draw.initial_capacity = MAX(max_primitives,16);
+    slog("debug draw initialized");
+    atexit(gf2d_debug_draw_close);
+}
+
+/**
+ * @brief make sure an array has room for more elements, doubling it when it does not
+ * @return 0 if it could not grow
+ */
+static Uint8 gf2d_debug_draw_reserve(void **array,Uint32 *capacity,Uint32 needed,size_t size)
+{
+    Uint32 new_capacity;
+    void *grown;
+    if (needed <= *capacity)return 1;
+    new_capacity = MAX(*capacity,gf2d_debug_draw.initial_capacity);
+    if (!new_capacity)new_capacity = 16;
+    while (new_capacity < needed)new_capacity *= 2;
+    grown = realloc(*array,size * new_capacity);
+    if (!grown)
+    {
+        slog("failed to grow debug draw buffer to %i",new_capacity);
+        return 0;
+    }
+    *array = grown;
+    *capacity = new_capacity;
+    return 1;
+}
+
+/**
+ * @brief get the group for a color, starting a new one if this is the first time it is seen this frame
+ */
+static DebugDrawGroup *gf2d_debug_draw_get_group(GFC_Color color)
+{
+    Uint32 i;
+    DebugDrawGroup *group;
+    GFC_Color drawColor = gfc_color_to_int8(color);
+    SDL_Color key = {drawColor.r,drawColor.g,drawColor.b,drawColor.a};
+    for (i = 0;i < gf2d_debug_draw.group_count;i++)
+    {
+        group = &gf2d_debug_draw.groups[i];
+        if ((group->color.r == key.r)&&(group->color.g == key.g)&&(group->color.b == key.b)&&(group->color.a == key.a))
+        {
+            return group;
+        }
+    }
+    if (gf2d_debug_draw.group_count >= GF2D_DEBUG_DRAW_COLORS)
+    {
+        // out of groups, draw what is here and start over
+        gf2d_debug_draw_flush();
+    }
+    group = &gf2d_debug_draw.groups[gf2d_debug_draw.group_count++];
+    group->color = key;
+    return group;
+}
+
+void gf2d_debug_draw_point(GFC_Vector2D point,GFC_Color color)
+{
+    DebugDrawGroup *group = gf2d_debug_draw_get_group(color);
+    if (!gf2d_debug_draw_reserve((void **)&group->points,&group->point_capacity,group->point_count + 1,sizeof(SDL_Point)))return;
+    group->points[group->point_count].x = point.x;
+    group->points[group->point_count].y = point.y;
+    group->point_count++;
+}
+
+void gf2d_debug_draw_line(GFC_Vector2D p1,GFC_Vector2D p2,GFC_Color color)
+{
+    SDL_Point *last;
+    DebugDrawGroup *group = gf2d_debug_draw_get_group(color);
+    if (!gf2d_debug_draw_reserve((void **)&group->line_points,&group->line_point_capacity,group->line_point_count + 2,sizeof(SDL_Point)))return;
+    if (group->line_point_count)
+    {
+        last = &group->line_points[group->line_point_count - 1];
+        if ((last->x == (int)p1.x)&&(last->y == (int)p1.y))
+        {
+            // continues the current strip
+            group->line_points[group->line_point_count].x = p2.x;
+            group->line_points[group->line_point_count].y = p2.y;
+            group->line_point_count++;
+            return;
+        }
+    }
+    if (!gf2d_debug_draw_reserve((void **)&group->strips,&group->strip_capacity,group->strip_count + 1,sizeof(Uint32)))return;
+    group->strips[group->strip_count++] = group->line_point_count;
+    group->line_points[group->line_point_count].x = p1.x;
+    group->line_points[group->line_point_count].y = p1.y;
+    group->line_points[group->line_point_count + 1].x = p2.x;
+    group->line_points[group->line_point_count + 1].y = p2.y;
+    group->line_point_count += 2;
+}
+
+void gf2d_debug_draw_rect(GFC_Rect rect,GFC_Color color)
+{
+    DebugDrawGroup *group = gf2d_debug_draw_get_group(color);
+    if (!gf2d_debug_draw_reserve((void **)&group->rects,&group->rect_capacity,group->rect_count + 1,sizeof(SDL_Rect)))return;
+    group->rects[group->rect_count++] = gfc_rect_to_sdl_rect(rect);
+}
+
+void gf2d_debug_draw_circle(GFC_Vector2D center,int radius,GFC_Color color)
+{
+    DebugDrawGroup *group;
+    if (radius <= 0)return;
+    group = gf2d_debug_draw_get_group(color);
+    if (!gf2d_debug_draw_reserve((void **)&group->points,&group->point_capacity,group->point_count + radius * 8,sizeof(SDL_Point)))return;
+    group->point_count += gf2d_draw_circle_to_points(&group->points[group->point_count],radius * 8,center,radius);
+}
+
+void gf2d_debug_draw_flush()
+{
+    Uint32 i,j,end;
+    DebugDrawGroup *group;
+    SDL_Renderer *renderer = gf2d_graphics_get_renderer();
+    if (!gf2d_debug_draw.group_count)return;
+    gf2d_batch_flush();
+    for (i = 0;i < gf2d_debug_draw.group_count;i++)
+    {
+        group = &gf2d_debug_draw.groups[i];
+        SDL_SetRenderDrawColor(renderer,group->color.r,group->color.g,group->color.b,group->color.a);
+        if (group->rect_count)SDL_RenderDrawRects(renderer,group->rects,group->rect_count);
+        if (group->point_count)SDL_RenderDrawPoints(renderer,group->points,group->point_count);
+        for (j = 0;j < group->strip_count;j++)
+        {
+            end = (j + 1 < group->strip_count)?group->strips[j + 1]:group->line_point_count;
+            SDL_RenderDrawLines(renderer,&group->line_points[group->strips[j]],end - group->strips[j]);
+        }
+        group->rect_count = 0;
+        group->point_count = 0;
+        group->line_point_count = 0;
+        group->strip_count = 0;
+    }
+    gf2d_debug_draw.group_count = 0;
+    SDL_SetRenderDrawColor(renderer,255,255,255,255);
+}
+
+#endif
+
+/*eol@eof*/
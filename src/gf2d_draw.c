@@ -4,6 +4,7 @@
 
 #include "gf2d_draw.h"
 #include "gf2d_graphics.h"
+#include "gf2d_batch.h"
 
 void gf2d_draw_shape(GFC_Shape shape,GFC_Color color,GFC_Vector2D offset)
 {
@@ -92,6 +93,7 @@ void gf2d_draw_polygon(GFC_List *points,GFC_Color color)
     array = gf2d_draw_point_list_to_array(points);
     if (!array)return;
     drawColor = gfc_color_to_int8(color);
+    gf2d_batch_flush();
     SDL_SetRenderDrawColor(gf2d_graphics_get_renderer(),
                            drawColor.r,
                            drawColor.g,
@@ -126,6 +128,7 @@ void gf2d_draw_point_list(GFC_List *points,GFC_Color color)
     GFC_Color drawColor;
     if (!points)return;
     drawColor = gfc_color_to_int8(color);
+    gf2d_batch_flush();
     SDL_SetRenderDrawColor(gf2d_graphics_get_renderer(),
                            drawColor.r,
                            drawColor.g,
@@ -159,6 +162,7 @@ void gf2d_draw_bezier4_curve(GFC_Vector2D p0,GFC_Vector2D r0,GFC_Vector2D r1,GFC
     GFC_Color drawColor;
     //source: https://programmerbay.com/c-program-to-draw-bezier-curve-using-4-control-points/
     drawColor = gfc_color_to_int8(color);
+    gf2d_batch_flush();
     SDL_SetRenderDrawColor(gf2d_graphics_get_renderer(),
                            drawColor.r,
                            drawColor.g,
@@ -213,6 +217,7 @@ void gf2d_draw_lines(GFC_Vector2D *p1,GFC_Vector2D *p2, Uint32 lines,GFC_Color c
     int i;
     GFC_Color drawColor;
     drawColor = gfc_color_to_int8(color);
+    gf2d_batch_flush();
     SDL_SetRenderDrawColor(gf2d_graphics_get_renderer(),
                            drawColor.r,
                            drawColor.g,
@@ -237,6 +242,7 @@ void gf2d_draw_line(GFC_Vector2D p1,GFC_Vector2D p2, GFC_Color color)
 {
     GFC_Color drawColor;
     drawColor = gfc_color_to_int8(color);
+    gf2d_batch_flush();
     SDL_SetRenderDrawColor(gf2d_graphics_get_renderer(),
                            drawColor.r,
                            drawColor.g,
@@ -260,6 +266,7 @@ void gf2d_draw_rect(GFC_Rect rect,GFC_Color color)
     SDL_Rect drawrect;
     drawrect = gfc_rect_to_sdl_rect(rect);
     drawColor = gfc_color_to_int8(color);
+    gf2d_batch_flush();
     SDL_SetRenderDrawColor(gf2d_graphics_get_renderer(),
                            drawColor.r,
                            drawColor.g,
@@ -274,6 +281,7 @@ void gf2d_draw_rect_filled(GFC_Rect rect,GFC_Color color)
     SDL_Rect drawrect;
     drawrect = gfc_rect_to_sdl_rect(rect);
     drawColor = gfc_color_to_int8(color);
+    gf2d_batch_flush();
     SDL_SetRenderDrawColor(gf2d_graphics_get_renderer(),
                            drawColor.r,
                            drawColor.g,
@@ -286,6 +294,7 @@ void gf2d_draw_rects(SDL_Rect *rects,Uint32 count,GFC_Color color)
 {
     GFC_Color drawColor;
     drawColor = gfc_color_to_int8(color);
+    gf2d_batch_flush();
     SDL_SetRenderDrawColor(gf2d_graphics_get_renderer(),
                            drawColor.r,
                            drawColor.g,
@@ -298,6 +307,7 @@ void gf2d_draw_pixel(GFC_Vector2D pixel,GFC_Color color)
 {
     GFC_Color drawColor;
     drawColor = gfc_color_to_int8(color);
+    gf2d_batch_flush();
     SDL_SetRenderDrawColor(gf2d_graphics_get_renderer(),
                            drawColor.r,
                            drawColor.g,
@@ -312,6 +322,7 @@ void gf2d_draw_pixel_list(SDL_Point * pixels,Uint32 count,GFC_Color color)
 {
     GFC_Color drawColor;
     drawColor = gfc_color_to_int8(color);
+    gf2d_batch_flush();
     SDL_SetRenderDrawColor(gf2d_graphics_get_renderer(),
                            drawColor.r,
                            drawColor.g,
@@ -360,22 +371,14 @@ static int gf2d_draw_circle_points(SDL_Point *p,GFC_Vector2D center, GFC_Vector2
   return 0;
 }
 
-void gf2d_draw_circle(GFC_Vector2D center, int radius, GFC_Color color)
+Uint32 gf2d_draw_circle_to_points(SDL_Point *points, Uint32 max, GFC_Vector2D center, int radius)
 {
-    SDL_Point *pointArray;
-    int i = 0;
+    Uint32 i = 0;
     GFC_Vector2D point = {0,0};
     int p = (5 - radius*4)/4;
-    GFC_Color drawColor;
-    drawColor = gfc_color_to_int8(color);
+    if ((!points)||(radius <= 0)||(max < 8))return 0;
     point.y = radius;
-    pointArray = (SDL_Point*)malloc(sizeof(SDL_Point)*radius*8);
-    if (!pointArray)
-    {
-        slog("gf2d_draw_circle: failed to allocate points for circle drawing");
-        return;
-    }
-    i = gf2d_draw_circle_points(&pointArray[i],center, point);
+    i = gf2d_draw_circle_points(&points[i],center, point);
     while (point.x < point.y)
     {
         point.x++;
@@ -388,24 +391,49 @@ void gf2d_draw_circle(GFC_Vector2D center, int radius, GFC_Color color)
             point.y--;
             p += 2*(point.x-point.y)+1;
         }
-        i += gf2d_draw_circle_points(&pointArray[i],center, point);
-        if (i + 8 >= radius*8)
+        if (i + 8 > max)
         {
             break;
         }
+        i += gf2d_draw_circle_points(&points[i],center, point);
+    }
+    return i;
+}
+
+static SDL_Point *gf2d_draw_circle_buffer = NULL;   /**<reused by every circle so drawing one does not allocate*/
+static Uint32 gf2d_draw_circle_capacity = 0;
+
+void gf2d_draw_circle(GFC_Vector2D center, int radius, GFC_Color color)
+{
+    SDL_Point *pointArray;
+    Uint32 i;
+    GFC_Color drawColor;
+    if (radius <= 0)return;
+    drawColor = gfc_color_to_int8(color);
+    if (gf2d_draw_circle_capacity < radius*8)
+    {
+        pointArray = (SDL_Point*)realloc(gf2d_draw_circle_buffer,sizeof(SDL_Point)*radius*8);
+        if (!pointArray)
+        {
+            slog("gf2d_draw_circle: failed to allocate points for circle drawing");
+            return;
+        }
+        gf2d_draw_circle_buffer = pointArray;
+        gf2d_draw_circle_capacity = radius*8;
     }
+    i = gf2d_draw_circle_to_points(gf2d_draw_circle_buffer,radius*8,center,radius);
+    gf2d_batch_flush();
     SDL_SetRenderDrawColor(gf2d_graphics_get_renderer(),
                            drawColor.r,
                            drawColor.g,
                            drawColor.b,
                            drawColor.a);
-    SDL_RenderDrawPoints(gf2d_graphics_get_renderer(),pointArray,i);
+    SDL_RenderDrawPoints(gf2d_graphics_get_renderer(),gf2d_draw_circle_buffer,i);
     SDL_SetRenderDrawColor(gf2d_graphics_get_renderer(),
                             255,
                             255,
                             255,
                             255);
-    free(pointArray);
 }
 
 GFC_List *gf2d_draw_get_bezier4_points(
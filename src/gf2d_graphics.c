@@ -3,6 +3,9 @@
 #include <stdlib.h>
 
 #include "gf2d_graphics.h"
+#include "gf2d_batch.h"
+#include "gf2d_render_queue.h"
+#include "gf2d_debug_draw.h"
 #include "simple_logger.h"
 
 /*local types*/
@@ -205,6 +208,7 @@ SDL_Surface *gf2d_graphics_get_render()
                                     gf2d_graphics.bmask,
                                     gf2d_graphics.amask);
     if (!surface)return NULL;
+    gf2d_batch_flush();
     SDL_LockSurface(surface);
     SDL_RenderReadPixels(gf2d_graphics_get_renderer(),
                              NULL,
@@ -313,6 +317,9 @@ void gf2d_graphics_frame_delay()
 
 void gf2d_graphics_next_frame()
 {
+    gf2d_render_queue_flush();
+    gf2d_debug_draw_flush();
+    gf2d_batch_flush();
     SDL_RenderPresent(gf2d_graphics.renderer);
     gf2d_graphics_frame_delay();
 }
@@ -354,6 +361,7 @@ void gf2d_graphics_render_texture_to_screen(SDL_Texture *texture,const SDL_Rect
         slog("no graphics rendering context");
         return;
     }
+    gf2d_batch_flush();
     if (SDL_RenderCopy(gf2d_graphics.renderer,
                    texture,
                    srcRect,
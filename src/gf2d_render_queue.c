@@ -0,0 +1,186 @@
+#include <stdlib.h>
+
+#include "simple_logger.h"
+
+#include "gf2d_batch.h"
+#include "gf2d_render_queue.h"
+
+/**
+ * sort key layout, most significant first
+ * | layer (8) | depth (24) | texture id (16) | unused (16) |
+ */
+#define RENDER_KEY_LAYER_SHIFT   56
+#define RENDER_KEY_DEPTH_SHIFT   32
+#define RENDER_KEY_TEXTURE_SHIFT 16
+
+typedef struct
+{
+    Uint64 key;
+    Uint32 index;           /**<which command the key belongs to*/
+}RenderSortEntry;
+
+typedef struct
+{
+    GF2D_Quad *commands;    /**<the queued draws in submission order*/
+    RenderSortEntry *keys;  /**<sort keys of the queued draws*/
+    RenderSortEntry *scratch;/**<ping pong buffer for the radix sort*/
+    Uint32 count;
+    Uint32 capacity;
+}RenderQueue;
+
+static RenderQueue render_queue = {0};
+
+void gf2d_render_queue_close()
+{
+    if (render_queue.commands)free(render_queue.commands);
+    if (render_queue.keys)free(render_queue.keys);
+    if (render_queue.scratch)free(render_queue.scratch);
+    memset(&render_queue,0,sizeof(RenderQueue));
+    slog("render queue closed");
+}
+
+/**
+ * @brief make room for at least capacity draws
+ * @return 0 on success, -1 if out of memory
+ */
+static int gf2d_render_queue_reserve(Uint32 capacity)
+{
+    GF2D_Quad *commands;
+    RenderSortEntry *keys,*scratch;
+    if (capacity <= render_queue.capacity)return 0;
+    commands = (GF2D_Quad *)realloc(render_queue.commands,sizeof(GF2D_Quad)*capacity);
+    if (!commands)return -1;
+    render_queue.commands = commands;
+    keys = (RenderSortEntry *)realloc(render_queue.keys,sizeof(RenderSortEntry)*capacity);
+    if (!keys)return -1;
+    render_queue.keys = keys;
+    scratch = (RenderSortEntry *)realloc(render_queue.scratch,sizeof(RenderSortEntry)*capacity);
+    if (!scratch)return -1;
+    render_queue.scratch = scratch;
+    render_queue.capacity = capacity;
+    return 0;
+}
+
+void gf2d_render_queue_init(Uint32 max_commands)
+{
+    if (render_queue.capacity)return;
+    if (gf2d_render_queue_reserve(max_commands ? max_commands : 1) != 0)
+    {
+        slog("failed to allocate render queue for %i commands",max_commands);
+        return;
+    }
+    slog("render queue initialized");
+    atexit(gf2d_render_queue_close);
+}
+
+/**
+ * @brief map a float to 24 bits that sort in the same order as the float
+ */
+static Uint32 gf2d_render_queue_depth_bits(float depth)
+{
+    union
+    {
+        float f;
+        Uint32 u;
+    }bits;
+    bits.f = depth;
+    // flip every bit of negatives and just the sign bit of positives, so the bits sort like the numbers
+    bits.u = (bits.u & 0x80000000) ? ~bits.u : (bits.u | 0x80000000);
+    return bits.u >> 8;
+}
+
+void gf2d_render_queue_sprite(
+    Sprite * sprite,
+    GFC_Vector2D position,
+    GFC_Vector2D * scale,
+    GFC_Vector2D * center,
+    float    * rotation,
+    GFC_Vector2D * flip,
+    GFC_Color    * color,
+    GFC_Vector4D * clip,
+    Uint32 frame,
+    Uint8 layer,
+    float depth)
+{
+    RenderSortEntry *entry;
+    if (!sprite)return;
+    if (render_queue.count >= render_queue.capacity)
+    {
+        if (!render_queue.capacity)gf2d_render_queue_init(1024);
+        if (gf2d_render_queue_reserve(render_queue.capacity * 2) != 0)
+        {
+            slog("failed to grow render queue to %i commands",render_queue.capacity * 2);
+            return;
+        }
+    }
+    if (!gf2d_sprite_get_quad(sprite,position,scale,center,rotation,flip,color,clip,frame,&render_queue.commands[render_queue.count]))return;
+
+    entry = &render_queue.keys[render_queue.count];
+    entry->index = render_queue.count;
+    entry->key = ((Uint64)layer << RENDER_KEY_LAYER_SHIFT)
+        | ((Uint64)gf2d_render_queue_depth_bits(depth) << RENDER_KEY_DEPTH_SHIFT)
+        | ((Uint64)(gf2d_sprite_get_texture_id(sprite) & 0xFFFF) << RENDER_KEY_TEXTURE_SHIFT);
+    render_queue.count++;
+}
+
+/**
+ * @brief stable least significant digit radix sort of the keys, a byte at a time
+ * @note bytes that are the same in every key are skipped, so unused key bits cost nothing
+ */
+static void gf2d_render_queue_sort()
+{
+    Uint32 counts[256];
+    Uint32 i,pass,offset,total;
+    Uint64 same = ~(Uint64)0;
+    RenderSortEntry *from = render_queue.keys,*to = render_queue.scratch,*swap;
+    Uint8 byte;
+
+    // find which bytes actually vary between keys
+    for (i = 1;i < render_queue.count;i++)
+    {
+        same &= ~(render_queue.keys[i].key ^ render_queue.keys[0].key);
+    }
+
+    for (pass = 0;pass < 8;pass++)
+    {
+        if (((same >> (pass * 8)) & 0xFF) == 0xFF)continue;
+        memset(counts,0,sizeof(counts));
+        for (i = 0;i < render_queue.count;i++)
+        {
+            counts[(from[i].key >> (pass * 8)) & 0xFF]++;
+        }
+        for (i = 0,total = 0;i < 256;i++)
+        {
+            offset = counts[i];
+            counts[i] = total;
+            total += offset;
+        }
+        for (i = 0;i < render_queue.count;i++)
+        {
+            byte = (from[i].key >> (pass * 8)) & 0xFF;
+            to[counts[byte]++] = from[i];
+        }
+        swap = from;
+        from = to;
+        to = swap;
+    }
+    // keep the sorted keys in the keys buffer
+    render_queue.keys = from;
+    render_queue.scratch = to;
+}
+
+void gf2d_render_queue_flush()
+{
+    Uint32 i;
+    GF2D_Quad *quad;
+    if (!render_queue.count)return;
+    gf2d_render_queue_sort();
+    for (i = 0;i < render_queue.count;i++)
+    {
+        quad = &render_queue.commands[render_queue.keys[i].index];
+        gf2d_batch_quad(quad->texture,&quad->src,quad->corners,quad->color,quad->flip);
+    }
+    render_queue.count = 0;
+}
+
+/*eol@eof*/
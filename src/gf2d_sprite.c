@@ -8,19 +8,62 @@
 #include "gfc_pak.h"
 
 #include "gf2d_graphics.h"
+#include "gf2d_atlas.h"
 
 #include "gf2d_sprite.h"
 
+#define SPRITE_HASH_EMPTY -1
+#define SPRITE_HASH_REMOVED -2
+
+typedef struct
+{
+    Uint32 hash;    /**<hash of the sprite's filepath*/
+    Sint32 slot;    /**<index into the sprite list, or one of the SPRITE_HASH_ markers*/
+}SpriteHashEntry;
+
 typedef struct
 {
     Uint32 max_sprites;
     Sprite * sprite_list;
+    SpriteHashEntry *hash_table;    /**<open addressed index of loaded sprites by filepath*/
+    Uint32 hash_mask;               /**<table size minus one, the size is a power of two*/
+    Uint32 hash_used;               /**<live and removed entries, used to decide when to rebuild*/
+    SDL_Texture *placeholder;       /**<drawn in place of sprites that are still loading*/
+    SDL_Thread *loader;             /**<decodes images for gf2d_sprite_load_async*/
+    SDL_mutex *loader_lock;         /**<guards the job queues and loader_quit*/
+    SDL_cond *loader_wake;          /**<signalled when a job is queued or the loader should quit*/
+    Uint8 loader_quit;
+    struct SpriteLoadJob_S *pending;    /**<images waiting to be decoded, oldest first*/
+    struct SpriteLoadJob_S *finished;   /**<decoded images waiting to be uploaded, oldest first*/
+    struct SpriteLoadJob_S *finished_last;  /**<the newest decoded image, new ones go after it*/
+    Uint32 load_count;              /**<counts async loads so a finished job can tell if its sprite was reused*/
+    Uint64 resident_bytes;          /**<sum of every sprite's bytes*/
+    Uint64 budget;                  /**<most bytes to keep resident before evicting, 0 for no limit*/
+    Uint32 clock;                   /**<ticks on every load and release, orders sprites for eviction*/
+    Uint32 lookups;
+    Uint32 hits;
+    Uint32 evictions;
 }SpriteManager;
 
+typedef struct SpriteLoadJob_S
+{
+    struct SpriteLoadJob_S *next;
+    GFC_TextLine filepath;
+    Sprite *sprite;             /**<the sprite handed out when the load was queued*/
+    Uint32 load_id;             /**<the sprite's loading id when the load was queued*/
+    SDL_Surface *surface;       /**<the decoded and converted image, NULL if it failed to load*/
+    Sint32 frame_w,frame_h;
+    Sint32 frames_per_line;
+    Bool keep_surface;
+}SpriteLoadJob;
+
 static SpriteManager sprite_manager = {0};
 
+static void gf2d_sprite_loader_stop();
+
 void gf2d_sprite_close()
 {
+    gf2d_sprite_loader_stop();
     gf2d_sprite_clear_all();
     if (sprite_manager.sprite_list != NULL)
     {
@@ -28,11 +71,111 @@ void gf2d_sprite_close()
     }
     sprite_manager.sprite_list = NULL;
     sprite_manager.max_sprites = 0;
+    if (sprite_manager.hash_table != NULL)
+    {
+        free(sprite_manager.hash_table);
+    }
+    sprite_manager.hash_table = NULL;
+    sprite_manager.hash_mask = 0;
+    sprite_manager.hash_used = 0;
+    if (sprite_manager.placeholder != NULL)
+    {
+        gf2d_batch_release_texture(sprite_manager.placeholder);
+        SDL_DestroyTexture(sprite_manager.placeholder);
+    }
+    sprite_manager.placeholder = NULL;
     slog("sprite system closed");
 }
 
+static Uint32 gf2d_sprite_hash(const char *filename)
+{
+    // FNV-1a
+    Uint32 hash = 2166136261u;
+    while (*filename)
+    {
+        hash ^= (Uint8)*filename++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void gf2d_sprite_hash_clear()
+{
+    Uint32 i;
+    for (i = 0;i <= sprite_manager.hash_mask;i++)
+    {
+        sprite_manager.hash_table[i].slot = SPRITE_HASH_EMPTY;
+    }
+    sprite_manager.hash_used = 0;
+}
+
+static void gf2d_sprite_hash_insert(Sprite *sprite)
+{
+    Uint32 i,hash;
+    Sint32 slot;
+    if (!sprite_manager.hash_table)return;
+    hash = gf2d_sprite_hash(sprite->filepath);
+    slot = sprite - sprite_manager.sprite_list;
+    for (i = hash & sprite_manager.hash_mask;;i = (i + 1) & sprite_manager.hash_mask)
+    {
+        if (sprite_manager.hash_table[i].slot == SPRITE_HASH_REMOVED)break;
+        if (sprite_manager.hash_table[i].slot == SPRITE_HASH_EMPTY)
+        {
+            sprite_manager.hash_used++;
+            break;
+        }
+    }
+    sprite_manager.hash_table[i].hash = hash;
+    sprite_manager.hash_table[i].slot = slot;
+}
+
+/**
+ * @brief drop the removed markers once they make up a quarter of the table, so misses stay short
+ */
+static void gf2d_sprite_hash_rebuild()
+{
+    Uint32 i;
+    gf2d_sprite_hash_clear();
+    for (i = 0;i < sprite_manager.max_sprites;i++)
+    {
+        if (!sprite_manager.sprite_list[i].filepath[0])continue;
+        gf2d_sprite_hash_insert(&sprite_manager.sprite_list[i]);
+    }
+}
+
+/**
+ * @brief find the table entry for a filepath
+ * @return the entry's index, or -1 if it is not loaded
+ */
+static Sint32 gf2d_sprite_hash_find(const char *filename)
+{
+    Uint32 i,hash;
+    Sint32 slot;
+    if (!sprite_manager.hash_table)return -1;
+    hash = gf2d_sprite_hash(filename);
+    for (i = hash & sprite_manager.hash_mask;;i = (i + 1) & sprite_manager.hash_mask)
+    {
+        slot = sprite_manager.hash_table[i].slot;
+        if (slot == SPRITE_HASH_EMPTY)return -1;
+        if ((slot >= 0)&&(sprite_manager.hash_table[i].hash == hash)&&
+            (gfc_line_cmp(sprite_manager.sprite_list[slot].filepath,filename)==0))
+        {
+            return i;
+        }
+    }
+}
+
+static void gf2d_sprite_hash_remove(Sprite *sprite)
+{
+    Sint32 i;
+    i = gf2d_sprite_hash_find(sprite->filepath);
+    if (i < 0)return;
+    sprite_manager.hash_table[i].slot = SPRITE_HASH_REMOVED;
+}
+
 void gf2d_sprite_init(Uint32 max)
 {
+    Uint32 size;
     if (!max)
     {
         slog("cannot intialize a sprite manager for Zero sprites!");
@@ -41,6 +184,14 @@ void gf2d_sprite_init(Uint32 max)
     sprite_manager.max_sprites = max;
     sprite_manager.sprite_list = (Sprite *)malloc(sizeof(Sprite)*max);
     memset (sprite_manager.sprite_list,0,sizeof(Sprite)*max);
+    // at most half full, so probes stay short
+    for (size = 2;size < max * 2;size <<= 1);
+    sprite_manager.hash_table = (SpriteHashEntry *)gfc_allocate_array(sizeof(SpriteHashEntry),size);
+    if (sprite_manager.hash_table)
+    {
+        sprite_manager.hash_mask = size - 1;
+        gf2d_sprite_hash_clear();
+    }
     if (!(IMG_Init( IMG_INIT_PNG) & IMG_INIT_PNG))
     {
         slog("failed to init image: %s",SDL_GetError());
@@ -50,24 +201,233 @@ void gf2d_sprite_init(Uint32 max)
     atexit(gf2d_sprite_close);
 }
 
+/**
+ * @brief destroy a sprite's downscaled copies
+ */
+static void gf2d_sprite_free_mips(Sprite *sprite)
+{
+    Uint32 i;
+    int w,h;
+    for (i = 0;i < sprite->mip_count;i++)
+    {
+        if (!sprite->mips[i])continue;
+        SDL_QueryTexture(sprite->mips[i],NULL,NULL,&w,&h);
+        sprite->bytes -= w * h * 4;
+        sprite_manager.resident_bytes -= w * h * 4;
+        gf2d_batch_release_texture(sprite->mips[i]);
+        SDL_DestroyTexture(sprite->mips[i]);
+        sprite->mips[i] = NULL;
+    }
+    sprite->mip_count = 0;
+}
+
+/**
+ * @brief shrink a 32 bit surface to half its size with a 2x2 box filter
+ * @note colors are weighted by alpha so transparent pixels do not darken the edges around them
+ * @return NULL on error, otherwise a new surface in the same format
+ */
+static SDL_Surface *gf2d_sprite_downsample(SDL_Surface *surface)
+{
+    SDL_Surface *half;
+    Uint8 *src,*dst;
+    Uint32 sum[4],weight,alpha;
+    int x,y,i,j,c,a;
+    if ((!surface)||(surface->format->BytesPerPixel != 4))return NULL;
+    half = SDL_CreateRGBSurfaceWithFormat(0,surface->w / 2,surface->h / 2,32,surface->format->format);
+    if (!half)return NULL;
+    a = (surface->format->Amask)?surface->format->Ashift / 8:-1;
+    SDL_LockSurface(surface);
+    SDL_LockSurface(half);
+    for (y = 0;y < half->h;y++)
+    {
+        dst = (Uint8 *)half->pixels + y * half->pitch;
+        for (x = 0;x < half->w;x++,dst += 4)
+        {
+            memset(sum,0,sizeof(sum));
+            weight = 0;
+            for (j = 0;j < 2;j++)
+            {
+                src = (Uint8 *)surface->pixels + (y * 2 + j) * surface->pitch + x * 8;
+                for (i = 0;i < 2;i++,src += 4)
+                {
+                    alpha = (a >= 0)?src[a]:255;
+                    weight += alpha;
+                    for (c = 0;c < 4;c++)
+                    {
+                        sum[c] += (c == a)?src[c]:src[c] * alpha;
+                    }
+                }
+            }
+            for (c = 0;c < 4;c++)
+            {
+                if (c == a)dst[c] = sum[c] / 4;
+                else dst[c] = (weight)?sum[c] / weight:0;
+            }
+        }
+    }
+    SDL_UnlockSurface(half);
+    SDL_UnlockSurface(surface);
+    return half;
+}
+
+void gf2d_sprite_build_mips(Sprite *sprite,SDL_Surface *surface)
+{
+    SDL_Surface *level,*next;
+    Uint32 i,fw,fh;
+    if ((!sprite)||(!surface))return;
+    gf2d_sprite_free_mips(sprite);
+    // a separate texture per level would break the atlas page's batches, so atlased sprites scale the page instead
+    if (sprite->atlased)return;
+    level = surface;
+    fw = sprite->frame_w;
+    fh = sprite->frame_h;
+    for (i = 0;i < GF2D_SPRITE_MIP_LEVELS;i++)
+    {
+        // stop once frames would no longer line up with whole pixels, or would get too small to be worth it
+        if ((fw % 2)||(fh % 2)||(level->w % 2)||(level->h % 2))break;
+        fw /= 2;
+        fh /= 2;
+        if ((fw < GF2D_SPRITE_MIP_MIN_FRAME)||(fh < GF2D_SPRITE_MIP_MIN_FRAME))break;
+        next = gf2d_sprite_downsample(level);
+        if (level != surface)SDL_FreeSurface(level);
+        level = next;
+        if (!level)return;
+        sprite->mips[i] = SDL_CreateTextureFromSurface(gf2d_graphics_get_renderer(),level);
+        if (!sprite->mips[i])break;
+        SDL_SetTextureBlendMode(sprite->mips[i],SDL_BLENDMODE_BLEND);
+        sprite->mip_count++;
+        sprite->bytes += level->w * level->h * 4;
+        sprite_manager.resident_bytes += level->w * level->h * 4;
+    }
+    if (level != surface)SDL_FreeSurface(level);
+}
+
+void gf2d_sprite_update_mips(Sprite *sprite,SDL_Surface *surface,SDL_Rect region)
+{
+    SDL_Surface *level,*next,*converted;
+    SDL_Rect target;
+    Uint32 i,format,align;
+    if ((!sprite)||(!surface)||(!sprite->mip_count))return;
+    align = 1 << sprite->mip_count;
+    if ((region.x % align)||(region.y % align)||(region.w % align)||(region.h % align))
+    {
+        // the edit would smear across pixels of the smaller copies, draw full size until they are rebuilt
+        gf2d_sprite_free_mips(sprite);
+        return;
+    }
+    level = surface;
+    target = region;
+    for (i = 0;i < sprite->mip_count;i++)
+    {
+        next = gf2d_sprite_downsample(level);
+        if (level != surface)SDL_FreeSurface(level);
+        level = next;
+        if (!level)return;
+        target.x /= 2;
+        target.y /= 2;
+        target.w /= 2;
+        target.h /= 2;
+        SDL_QueryTexture(sprite->mips[i],&format,NULL,NULL,NULL);
+        converted = SDL_ConvertSurfaceFormat(level,format,0);
+        if (!converted)continue;
+        SDL_UpdateTexture(sprite->mips[i],&target,converted->pixels,converted->pitch);
+        SDL_FreeSurface(converted);
+    }
+    if (level != surface)SDL_FreeSurface(level);
+}
+
 void gf2d_sprite_delete(Sprite *sprite)
 {
     if (!sprite)return;
+    if (sprite->filepath[0])
+    {
+        gf2d_sprite_hash_remove(sprite);
+    }
+    gf2d_sprite_free_mips(sprite);
+    sprite_manager.resident_bytes -= sprite->bytes;
     if (sprite->surface != NULL)
     {
         SDL_FreeSurface(sprite->surface);
     }
-    if (sprite->texture != NULL)
+    if ((sprite->texture != NULL)&&(!sprite->atlased))
     {
+        gf2d_batch_release_texture(sprite->texture);
         SDL_DestroyTexture(sprite->texture);
     }    
+    if (sprite->atlased)
+    {
+        gf2d_atlas_remove(sprite->atlas_page,&sprite->atlas_rect);
+    }
     memset(sprite,0,sizeof(Sprite));//clean up all other data
 }
 
+/**
+ * @brief delete the least recently used unreferenced sprites until the resident bytes fit the budget
+ */
+static void gf2d_sprite_enforce_budget()
+{
+    Uint32 i;
+    Sprite *oldest;
+    if (!sprite_manager.budget)return;
+    while (sprite_manager.resident_bytes > sprite_manager.budget)
+    {
+        oldest = NULL;
+        for (i = 0;i < sprite_manager.max_sprites;i++)
+        {
+            if ((sprite_manager.sprite_list[i].ref_count > 0)||(!sprite_manager.sprite_list[i].bytes))continue;
+            if ((!oldest)||(sprite_manager.sprite_list[i].last_used < oldest->last_used))
+            {
+                oldest = &sprite_manager.sprite_list[i];
+            }
+        }
+        if (!oldest)return;// everything left is in use
+        gf2d_sprite_delete(oldest);
+        sprite_manager.evictions++;
+    }
+}
+
+/**
+ * @brief mark a sprite as just used, for least recently used eviction
+ */
+static void gf2d_sprite_touch(Sprite *sprite)
+{
+    sprite->last_used = ++sprite_manager.clock;
+}
+
 void gf2d_sprite_free(Sprite *sprite)
 {
     if (!sprite) return;
     sprite->ref_count--;
+    if (sprite->ref_count <= 0)
+    {
+        gf2d_sprite_touch(sprite);
+        gf2d_sprite_enforce_budget();
+    }
+}
+
+void gf2d_sprite_set_memory_budget(Uint64 bytes)
+{
+    sprite_manager.budget = bytes;
+    gf2d_sprite_enforce_budget();
+}
+
+void gf2d_sprite_get_stats(SpriteStats *stats)
+{
+    Uint32 i;
+    if (!stats)return;
+    memset(stats,0,sizeof(SpriteStats));
+    stats->resident_bytes = sprite_manager.resident_bytes;
+    stats->atlas_bytes = gf2d_atlas_get_bytes();
+    stats->budget = sprite_manager.budget;
+    stats->lookups = sprite_manager.lookups;
+    stats->hits = sprite_manager.hits;
+    stats->evictions = sprite_manager.evictions;
+    for (i = 0;i < sprite_manager.max_sprites;i++)
+    {
+        if ((!sprite_manager.sprite_list[i].texture)&&(!sprite_manager.sprite_list[i].surface))continue;
+        stats->resident_sprites++;
+        if (sprite_manager.sprite_list[i].ref_count <= 0)stats->cached_sprites++;
+    }
 }
 
 void gf2d_sprite_clear_all()
@@ -82,51 +442,128 @@ void gf2d_sprite_clear_all()
 Sprite *gf2d_sprite_new()
 {
     int i;
+    Sprite *oldest = NULL;
     /*search for an unused sprite address*/
     for (i = 0;i < sprite_manager.max_sprites;i++)
     {
         if ((sprite_manager.sprite_list[i].ref_count == 0)&&(sprite_manager.sprite_list[i].texture == NULL))
         {
-            memset(&sprite_manager.sprite_list[i],0,sizeof(Sprite));
+            gf2d_sprite_delete(&sprite_manager.sprite_list[i]);// a freed sprite that was still loading keeps its filepath indexed
             sprite_manager.sprite_list[i].ref_count = 1;//set ref count
             return &sprite_manager.sprite_list[i];//return address of this array element        }
         }
     }
-    /*find an unused sprite address and clean up the old data*/
+    /*find the least recently used unreferenced sprite and clean up the old data*/
     for (i = 0;i < sprite_manager.max_sprites;i++)
     {
-        if (sprite_manager.sprite_list[i].ref_count <= 0)
+        if (sprite_manager.sprite_list[i].ref_count > 0)continue;
+        if ((!oldest)||(sprite_manager.sprite_list[i].last_used < oldest->last_used))
         {
-            gf2d_sprite_delete(&sprite_manager.sprite_list[i]);// clean up the old data
-            sprite_manager.sprite_list[i].ref_count = 1;//set ref count
-            return &sprite_manager.sprite_list[i];//return address of this array element
+            oldest = &sprite_manager.sprite_list[i];
         }
     }
+    if (oldest)
+    {
+        gf2d_sprite_delete(oldest);// clean up the old data
+        sprite_manager.evictions++;
+        oldest->ref_count = 1;//set ref count
+        return oldest;
+    }
     slog("error: out of sprite addresses");
     return NULL;
 }
 
 Sprite *gf2d_sprite_get_by_filename(const char * filename)
 {
-    int i;
+    Sint32 i;
     if (!filename)
     {
         slog("cannot find blank filename");
         return NULL;
     }
-    for (i = 0;i < sprite_manager.max_sprites;i++)
+    i = gf2d_sprite_hash_find(filename);
+    if (i < 0)return NULL;// not found
+    return &sprite_manager.sprite_list[sprite_manager.hash_table[i].slot];
+}
+
+Sprite *gf2d_sprite_load_image(const char *filename)
+{
+    return gf2d_sprite_load_all(filename,-1,-1,1,false);
+}
+
+/**
+ * @brief create a sprite's texture from a decoded and converted image and fill in its frame data
+ * @param sprite the sprite to finish
+ * @param surface the image, freed or kept by the sprite depending on keepSurface
+ * @return 0 on error, in which case the surface has been freed, 1 otherwise
+ */
+static Uint8 gf2d_sprite_upload(
+    Sprite *sprite,
+    SDL_Surface *surface,
+    Sint32  frameWidth,
+    Sint32  frameHeight,
+    Sint32  framesPerLine,
+    Bool    keepSurface)
+{
+    // either path uploads the pixels exactly once
+    if (gf2d_atlas_add(surface,&sprite->texture,&sprite->atlas_rect,&sprite->atlas_page))
+    {
+        sprite->atlased = 1;
+    }
+    else
     {
-        if (gfc_line_cmp(sprite_manager.sprite_list[i].filepath,filename)==0)
+        sprite->texture = SDL_CreateTextureFromSurface(gf2d_graphics_get_renderer(),surface);
+        if (!sprite->texture)
         {
-            return &sprite_manager.sprite_list[i];
+            slog("failed to create sprite texture: %s",SDL_GetError());
+            SDL_FreeSurface(surface);
+            return 0;
         }
+        SDL_SetTextureBlendMode(sprite->texture,SDL_BLENDMODE_BLEND);        
+    }
+    if (frameHeight == -1)
+    {
+        sprite->frame_h = surface->h;
+    }
+    else sprite->frame_h = frameHeight;
+    if (frameWidth == -1)
+    {
+        sprite->frame_w = surface->w;
+    }
+    else sprite->frame_w = frameWidth;
+    sprite->frames_per_line = framesPerLine;
+
+    // textures are counted at four bytes a pixel, atlas pages belong to the atlas
+    if (!sprite->atlased)sprite->bytes = surface->w * surface->h * 4;
+    sprite_manager.resident_bytes += sprite->bytes;
+    gf2d_sprite_build_mips(sprite,surface);
+    if(!keepSurface)
+    {
+        SDL_FreeSurface(surface);
     }
-    return NULL;// not found
+    else
+    {
+        sprite->surface = surface;
+        sprite->bytes += surface->h * surface->pitch;
+        sprite_manager.resident_bytes += surface->h * surface->pitch;
+    }
+    gf2d_sprite_touch(sprite);
+    gf2d_sprite_enforce_budget();
+    return 1;
 }
 
-Sprite *gf2d_sprite_load_image(const char *filename)
+/**
+ * @brief give a sprite its filepath and add it to the filepath index
+ */
+static void gf2d_sprite_set_filepath(Sprite *sprite,const char *filename)
 {
-    return gf2d_sprite_load_all(filename,-1,-1,1,false);
+    // rebuild first, the rebuild indexes every sprite with a filepath and this one must only go in once
+    if (sprite_manager.hash_used * 4 >= (sprite_manager.hash_mask + 1) * 3)
+    {
+        gf2d_sprite_hash_rebuild();
+    }
+    gfc_line_cpy(sprite->filepath,filename);
+    gf2d_sprite_hash_insert(sprite);
 }
 
 Sprite *gf2d_sprite_load_all(
@@ -145,11 +582,14 @@ Sprite *gf2d_sprite_load_all(
         return NULL;
     }
 
+    sprite_manager.lookups++;
     sprite = gf2d_sprite_get_by_filename(filename);
     if (sprite != NULL)
     {
         // found a copy already in memory
+        sprite_manager.hits++;
         sprite->ref_count++;
+        gf2d_sprite_touch(sprite);
         return sprite;
     }
     surface = IMG_Load(filename);
@@ -171,44 +611,217 @@ Sprite *gf2d_sprite_load_all(
         gf2d_sprite_free(sprite);
         return NULL;
     }
-    
-    sprite->texture = SDL_CreateTextureFromSurface(gf2d_graphics_get_renderer(),surface);
-    if (!sprite->texture)
+    if (!gf2d_sprite_upload(sprite,surface,frameWidth,frameHeight,framesPerLine,keepSurface))
     {
         slog("failed to load sprite image %s",filename);
-        gf2d_sprite_free(sprite);
-        SDL_FreeSurface(surface);
+        gf2d_sprite_delete(sprite);
         return NULL;
     }
-    SDL_SetTextureBlendMode(sprite->texture,SDL_BLENDMODE_BLEND);        
-    SDL_UpdateTexture(sprite->texture,
-                    NULL,
-                    surface->pixels,
-                    surface->pitch);
-    if (frameHeight == -1)
+    gf2d_sprite_set_filepath(sprite,filename);
+    return sprite;
+}
+
+/**
+ * @brief the loader thread, decodes and converts queued images until told to quit
+ */
+static int gf2d_sprite_loader_thread(void *data)
+{
+    SpriteLoadJob *job;
+    for (;;)
     {
-        sprite->frame_h = surface->h;
+        SDL_LockMutex(sprite_manager.loader_lock);
+        while ((!sprite_manager.pending)&&(!sprite_manager.loader_quit))
+        {
+            SDL_CondWait(sprite_manager.loader_wake,sprite_manager.loader_lock);
+        }
+        if (sprite_manager.loader_quit)
+        {
+            SDL_UnlockMutex(sprite_manager.loader_lock);
+            return 0;
+        }
+        job = sprite_manager.pending;
+        sprite_manager.pending = job->next;
+        SDL_UnlockMutex(sprite_manager.loader_lock);
+
+        job->surface = IMG_Load(job->filepath);
+        if (job->surface)
+        {
+            job->surface = gf2d_graphics_screen_convert(&job->surface);
+        }
+        else slog("failed to load sprite image %s",job->filepath);
+
+        // append, so images are uploaded in the order they were asked for
+        SDL_LockMutex(sprite_manager.loader_lock);
+        job->next = NULL;
+        if (sprite_manager.finished_last)sprite_manager.finished_last->next = job;
+        else sprite_manager.finished = job;
+        sprite_manager.finished_last = job;
+        SDL_UnlockMutex(sprite_manager.loader_lock);
     }
-    else sprite->frame_h = frameHeight;
-    if (frameWidth == -1)
+}
+
+/**
+ * @brief start the loader thread the first time something is loaded asynchronously
+ * @return 0 if the thread could not be started
+ */
+static Uint8 gf2d_sprite_loader_start()
+{
+    if (sprite_manager.loader)return 1;
+    sprite_manager.loader_lock = SDL_CreateMutex();
+    sprite_manager.loader_wake = SDL_CreateCond();
+    if ((!sprite_manager.loader_lock)||(!sprite_manager.loader_wake))
     {
-        sprite->frame_w = surface->w;
+        slog("failed to create sprite loader sync objects: %s",SDL_GetError());
+        return 0;
     }
-    else sprite->frame_w = frameWidth;
-    sprite->frames_per_line = framesPerLine;
-    gfc_line_cpy(sprite->filepath,filename);
+    sprite_manager.loader = SDL_CreateThread(gf2d_sprite_loader_thread,"sprite loader",NULL);
+    if (!sprite_manager.loader)
+    {
+        slog("failed to start sprite loader thread: %s",SDL_GetError());
+        return 0;
+    }
+    return 1;
+}
 
-    if(!keepSurface)
+/**
+ * @brief stop the loader thread and drop any loads still in flight
+ */
+static void gf2d_sprite_loader_stop()
+{
+    SpriteLoadJob *job;
+    if (sprite_manager.loader)
     {
-        SDL_FreeSurface(surface);
+        SDL_LockMutex(sprite_manager.loader_lock);
+        sprite_manager.loader_quit = 1;
+        SDL_CondSignal(sprite_manager.loader_wake);
+        SDL_UnlockMutex(sprite_manager.loader_lock);
+        SDL_WaitThread(sprite_manager.loader,NULL);
+        sprite_manager.loader = NULL;
     }
-    else
+    while (sprite_manager.pending)
     {
-        sprite->surface = surface;
+        job = sprite_manager.pending;
+        sprite_manager.pending = job->next;
+        free(job);
+    }
+    while (sprite_manager.finished)
+    {
+        job = sprite_manager.finished;
+        sprite_manager.finished = job->next;
+        if (job->surface)SDL_FreeSurface(job->surface);
+        free(job);
     }
+    sprite_manager.finished_last = NULL;
+    if (sprite_manager.loader_wake)SDL_DestroyCond(sprite_manager.loader_wake);
+    if (sprite_manager.loader_lock)SDL_DestroyMutex(sprite_manager.loader_lock);
+    sprite_manager.loader_wake = NULL;
+    sprite_manager.loader_lock = NULL;
+    sprite_manager.loader_quit = 0;
+}
+
+Sprite *gf2d_sprite_load_async(
+    const char   *filename,
+    Sint32  frameWidth,
+    Sint32  frameHeight,
+    Sint32  framesPerLine,
+    Bool    keepSurface
+)
+{
+    SpriteLoadJob *job,**tail;
+    Sprite *sprite = NULL;
+    if (!filename)
+    {
+        slog("cannot find blank filename");
+        return NULL;
+    }
+
+    sprite_manager.lookups++;
+    sprite = gf2d_sprite_get_by_filename(filename);
+    if (sprite != NULL)
+    {
+        // found a copy already in memory, or already on its way
+        sprite_manager.hits++;
+        sprite->ref_count++;
+        gf2d_sprite_touch(sprite);
+        return sprite;
+    }
+    if (!gf2d_sprite_loader_start())
+    {
+        return gf2d_sprite_load_all(filename,frameWidth,frameHeight,framesPerLine,keepSurface);
+    }
+    job = (SpriteLoadJob *)gfc_allocate_array(sizeof(SpriteLoadJob),1);
+    if (!job)return NULL;
+    sprite = gf2d_sprite_new();
+    if (!sprite)
+    {
+        free(job);
+        return NULL;
+    }
+    // until the image arrives the sprite draws the placeholder over its frame, if the frame size is known
+    if (!++sprite_manager.load_count)++sprite_manager.load_count;
+    sprite->loading = sprite_manager.load_count;
+    sprite->frame_w = (frameWidth > 0)?frameWidth:0;
+    sprite->frame_h = (frameHeight > 0)?frameHeight:0;
+    sprite->frames_per_line = framesPerLine;
+    gf2d_sprite_set_filepath(sprite,filename);
+
+    gfc_line_cpy(job->filepath,filename);
+    job->sprite = sprite;
+    job->load_id = sprite->loading;
+    job->frame_w = frameWidth;
+    job->frame_h = frameHeight;
+    job->frames_per_line = framesPerLine;
+    job->keep_surface = keepSurface;
+
+    // append, so images arrive in the order they were asked for
+    SDL_LockMutex(sprite_manager.loader_lock);
+    for (tail = &sprite_manager.pending;*tail;tail = &(*tail)->next);
+    *tail = job;
+    SDL_CondSignal(sprite_manager.loader_wake);
+    SDL_UnlockMutex(sprite_manager.loader_lock);
     return sprite;
 }
 
+void gf2d_sprite_async_update(Uint32 budget)
+{
+    SpriteLoadJob *job;
+    Sprite *sprite;
+    Uint64 start,limit;
+    if (!sprite_manager.loader)return;
+    start = SDL_GetPerformanceCounter();
+    limit = SDL_GetPerformanceFrequency() * budget / 1000;
+    for (;;)
+    {
+        SDL_LockMutex(sprite_manager.loader_lock);
+        job = sprite_manager.finished;
+        if (job)sprite_manager.finished = job->next;
+        if (!sprite_manager.finished)sprite_manager.finished_last = NULL;
+        SDL_UnlockMutex(sprite_manager.loader_lock);
+        if (!job)return;
+
+        // the sprite may have been deleted, and its slot reused, while the image was loading
+        sprite = job->sprite;
+        if ((sprite->loading != job->load_id)||(gfc_line_cmp(sprite->filepath,job->filepath) != 0))
+        {
+            if (job->surface)SDL_FreeSurface(job->surface);
+        }
+        else
+        {
+            // only this job's own sprite is done loading, a reused slot belongs to another load
+            sprite->loading = 0;
+            if ((!job->surface)||
+                (!gf2d_sprite_upload(sprite,job->surface,job->frame_w,job->frame_h,job->frames_per_line,job->keep_surface)))
+            {
+                // the caller still holds the handle, so leave it as a blank sprite that draws nothing
+                gf2d_sprite_hash_remove(sprite);
+                memset(sprite->filepath,0,sizeof(GFC_TextLine));
+            }
+        }
+        free(job);
+        if (SDL_GetPerformanceCounter() - start >= limit)return;
+    }
+}
+
 void gf2d_sprite_draw_to_surface(
     Sprite *sprite,
     GFC_Vector2D position,
@@ -300,7 +913,37 @@ void gf2d_sprite_draw(
         frame);
 }
 
-void gf2d_sprite_render(
+/**
+ * @brief get the texture drawn for sprites that are still loading, created the first time it is needed
+ */
+static SDL_Texture *gf2d_sprite_get_placeholder()
+{
+    Uint32 pixel = 0x80808080;// half transparent grey, ARGB
+    if (sprite_manager.placeholder)return sprite_manager.placeholder;
+    sprite_manager.placeholder = SDL_CreateTexture(
+        gf2d_graphics_get_renderer(),
+        SDL_PIXELFORMAT_ARGB8888,
+        SDL_TEXTUREACCESS_STATIC,
+        1,1);
+    if (!sprite_manager.placeholder)
+    {
+        slog("failed to create placeholder texture: %s",SDL_GetError());
+        return NULL;
+    }
+    SDL_UpdateTexture(sprite_manager.placeholder,NULL,&pixel,sizeof(Uint32));
+    SDL_SetTextureBlendMode(sprite_manager.placeholder,SDL_BLENDMODE_BLEND);
+    return sprite_manager.placeholder;
+}
+
+Uint32 gf2d_sprite_get_texture_id(Sprite *sprite)
+{
+    if ((!sprite)||(sprite < sprite_manager.sprite_list))return 0;
+    // sprites sharing an atlas page share an id so they sort next to each other
+    if (sprite->atlased)return sprite_manager.max_sprites + sprite->atlas_page;
+    return sprite - sprite_manager.sprite_list;
+}
+
+Uint8 gf2d_sprite_get_quad(
     Sprite * sprite,
     GFC_Vector2D position,
     GFC_Vector2D * scale,
@@ -309,21 +952,34 @@ void gf2d_sprite_render(
     GFC_Vector2D * flip,
     GFC_Color    * color,
     GFC_Vector4D * clip,
-    Uint32 frame)
+    Uint32 frame,
+    GF2D_Quad *quad)
 {
     float drawRotation = 0;
-    GFC_Vector4D colorShift = {1,1,1,1};
+    float cosine = 1,sine = 0,dx,dy;
+    GFC_Vector4D colorShift = {255,255,255,255};
     GFC_Vector4D drawClip = {0,0,1,1};
-    SDL_Rect cell,target;
+    SDL_FRect target;
+    SDL_FPoint *corners;
     SDL_RendererFlip flipFlags = SDL_FLIP_NONE;
-    SDL_Point r = {0,0};
-    int fpl;
+    GFC_Vector2D r = {0,0};
+    int fpl,i,mip;
     GFC_Vector2D scaleFactor = {1,1};
     GFC_Vector2D scaleOffset = {0,0};
-    if (!sprite)
+    if ((!sprite)||(!quad))
     {
-        return;
+        return 0;
+    }
+    if (sprite->loading)
+    {
+        // stand in for the sprite's frame until its image is uploaded
+        if ((!sprite->frame_w)||(!sprite->frame_h)||(!gf2d_sprite_get_placeholder()))return 0;
+    }
+    else if (!sprite->texture)
+    {
+        return 0;
     }
+    corners = quad->corners;
     if (clip)
     {
         gfc_vector4d_copy(drawClip,(*clip));
@@ -362,47 +1018,82 @@ void gf2d_sprite_render(
     if (color)
     {
         colorShift = gfc_color_to_vector4(gfc_color_to_int8(*color));
-        SDL_SetTextureColorMod(
-            sprite->texture,
-            colorShift.x,
-            colorShift.y,
-            colorShift.z);
-        SDL_SetTextureAlphaMod(
-            sprite->texture,
-            colorShift.w);
     }
+    quad->texture = (sprite->loading)?sprite_manager.placeholder:sprite->texture;
+    quad->color.r = colorShift.x;
+    quad->color.g = colorShift.y;
+    quad->color.b = colorShift.z;
+    quad->color.a = colorShift.w;
     
     fpl = (sprite->frames_per_line)?sprite->frames_per_line:1;
     gfc_rect_set(
-        cell,
+        quad->src,
         (frame%fpl * sprite->frame_w) + (drawClip.x * sprite->frame_w),
         (frame/fpl * sprite->frame_h) + (drawClip.y * sprite->frame_h),
         (sprite->frame_w * drawClip.z) - (drawClip.x * sprite->frame_w),
         (sprite->frame_h * drawClip.w) - (drawClip.y * sprite->frame_h));
+    // when drawn at half size or less, sample the smaller copy closest to the drawn size
+    for (mip = 0;(mip < sprite->mip_count)&&(MAX(scaleFactor.x,scaleFactor.y) * (2 << mip) <= 1);mip++);
+    if (sprite->loading)
+    {
+        gfc_rect_set(quad->src,0,0,1,1);
+    }
+    else if (mip)
+    {
+        quad->texture = sprite->mips[mip - 1];
+        gfc_rect_set(quad->src,quad->src.x >> mip,quad->src.y >> mip,quad->src.w >> mip,quad->src.h >> mip);
+    }
+    else if (sprite->atlased)
+    {
+        quad->src.x += sprite->atlas_rect.x;
+        quad->src.y += sprite->atlas_rect.y;
+    }
     gfc_rect_set(
         target,
         position.x - (scaleFactor.x * scaleOffset.x) + (drawClip.x * sprite->frame_w * scaleFactor.x),
         position.y - (scaleFactor.y * scaleOffset.y) + (drawClip.y * sprite->frame_h * scaleFactor.y),
         (sprite->frame_w * scaleFactor.x * drawClip.z) - (drawClip.x * sprite->frame_w * scaleFactor.x),
         (sprite->frame_h * scaleFactor.y * drawClip.w) - (drawClip.y * sprite->frame_h * scaleFactor.y));
-    SDL_RenderCopyEx(gf2d_graphics_get_renderer(),
-                     sprite->texture,
-                     &cell,
-                     &target,
-                     drawRotation,
-                     &r,
-                     flipFlags);
-    if (color)
+
+    // the quad's corners, rotated clockwise about the pivot like SDL_RenderCopyEx does
+    corners[0].x = target.x;
+    corners[0].y = target.y;
+    corners[1].x = target.x + target.w;
+    corners[1].y = target.y;
+    corners[2].x = target.x + target.w;
+    corners[2].y = target.y + target.h;
+    corners[3].x = target.x;
+    corners[3].y = target.y + target.h;
+    if (drawRotation)
     {
-        SDL_SetTextureColorMod(
-            sprite->texture,
-            255,
-            255,
-            255);
-        SDL_SetTextureAlphaMod(
-            sprite->texture,
-            255);
+        cosine = cos(drawRotation * GFC_DEGTORAD);
+        sine = sin(drawRotation * GFC_DEGTORAD);
+        for (i = 0;i < 4;i++)
+        {
+            dx = corners[i].x - (target.x + r.x);
+            dy = corners[i].y - (target.y + r.y);
+            corners[i].x = target.x + r.x + (dx * cosine) - (dy * sine);
+            corners[i].y = target.y + r.y + (dx * sine) + (dy * cosine);
+        }
     }
+    quad->flip = flipFlags;
+    return 1;
+}
+
+void gf2d_sprite_render(
+    Sprite * sprite,
+    GFC_Vector2D position,
+    GFC_Vector2D * scale,
+    GFC_Vector2D * center,
+    float    * rotation,
+    GFC_Vector2D * flip,
+    GFC_Color    * color,
+    GFC_Vector4D * clip,
+    Uint32 frame)
+{
+    GF2D_Quad quad;
+    if (!gf2d_sprite_get_quad(sprite,position,scale,center,rotation,flip,color,clip,frame,&quad))return;
+    gf2d_batch_quad(quad.texture,&quad.src,quad.corners,quad.color,quad.flip);
 }
 
 /*eol@eof*/
@@ -0,0 +1,134 @@
+#include <SDL.h>
+
+#include "simple_logger.h"
+
+#include "job.h"
+
+typedef struct {
+	SDL_Thread	*thread;	// <The worker's thread, NULL for the calling thread's slot
+	SDL_sem		*start;		// <Posted when the worker has a range to run
+	Uint32		index;		// <The worker's index
+	Uint32		begin;		// <First item in the worker's range
+	Uint32		end;		// <One past the last item in the worker's range
+}JobWorker;
+
+typedef struct {
+	Uint32		worker_count;	// <Number of workers, slot 0 is run by the calling thread
+	JobWorker	*workers;	// <The worker array
+	SDL_sem		*done;		// <Posted by each worker when its range is finished
+	Uint8		quit;		// <Set when the worker threads should exit
+
+	// Current job
+	JobFunction	job;		// <The function being run
+	void		*data;		// <The job's user data
+}JobSystem;
+
+static JobSystem job_system = {0};
+
+static int job_worker_main(void *data) {
+	JobWorker *worker = data;
+	for (;;) {
+		SDL_SemWait(worker->start);
+		if (job_system.quit) break;
+		job_system.job(worker->begin, worker->end, worker->index, job_system.data);
+		SDL_SemPost(job_system.done);
+	}
+	return 0;
+}
+
+/**
+ * @brief stop the worker threads and free the job system
+ */
+void job_system_close() {
+	Uint32 i;
+	if (!job_system.workers) return;
+
+	// Wake every worker so it sees the quit flag
+	job_system.quit = 1;
+	for (i = 1; i < job_system.worker_count; ++i) {
+		SDL_SemPost(job_system.workers[i].start);
+	}
+	for (i = 1; i < job_system.worker_count; ++i) {
+		SDL_WaitThread(job_system.workers[i].thread, NULL);
+		SDL_DestroySemaphore(job_system.workers[i].start);
+	}
+	if (job_system.done) SDL_DestroySemaphore(job_system.done);
+	free(job_system.workers);
+	memset(&job_system, 0, sizeof(JobSystem));
+	slog("job system closed");
+}
+
+void job_system_init(Uint32 thread_count) {
+	Uint32 i;
+	if (job_system.workers) return;
+	if (!thread_count) thread_count = SDL_GetCPUCount();
+	if (!thread_count) thread_count = 1;
+
+	job_system.workers = gfc_allocate_array(sizeof(JobWorker), thread_count);
+	if (!job_system.workers) {
+		slog("failed to allocate %i job workers", thread_count);
+		return;
+	}
+	job_system.done = SDL_CreateSemaphore(0);
+	if (!job_system.done) {
+		slog("failed to create job semaphore: %s", SDL_GetError());
+		free(job_system.workers);
+		job_system.workers = NULL;
+		return;
+	}
+
+	// Slot 0 belongs to the calling thread, the rest get their own threads
+	job_system.worker_count = 1;
+	for (i = 1; i < thread_count; ++i) {
+		job_system.workers[i].index = i;
+		job_system.workers[i].start = SDL_CreateSemaphore(0);
+		if (!job_system.workers[i].start) break;
+		job_system.workers[i].thread = SDL_CreateThread(job_worker_main, "job", &job_system.workers[i]);
+		if (!job_system.workers[i].thread) {
+			SDL_DestroySemaphore(job_system.workers[i].start);
+			job_system.workers[i].start = NULL;
+			break;
+		}
+		job_system.worker_count++;
+	}
+
+	atexit(job_system_close);
+	slog("job system initialized with %i threads", job_system.worker_count);
+}
+
+Uint32 job_system_worker_count() {
+	return job_system.worker_count ? job_system.worker_count : 1;
+}
+
+Uint32 job_system_run(Uint32 count, Uint32 min_per_worker, JobFunction job, void *data) {
+	Uint32 i, used, chunk;
+	if (!job || !count) return 0;
+
+	// Only split the work as far as it is worth it
+	used = min_per_worker ? count / min_per_worker : count;
+	if (used < 1) used = 1;
+	if (used > job_system_worker_count()) used = job_system_worker_count();
+	if (used == 1) {
+		job(0, count, 0, data);
+		return 1;
+	}
+	chunk = (count + used - 1) / used;
+
+	// Hand out contiguous ranges and start the workers
+	job_system.job = job;
+	job_system.data = data;
+	for (i = 0; i < used; ++i) {
+		job_system.workers[i].begin = MIN(i * chunk, count);
+		job_system.workers[i].end = MIN((i + 1) * chunk, count);
+	}
+	for (i = 1; i < used; ++i) {
+		SDL_SemPost(job_system.workers[i].start);
+	}
+
+	// The calling thread takes the first range
+	job(job_system.workers[0].begin, job_system.workers[0].end, 0, data);
+	for (i = 1; i < used; ++i) {
+		SDL_SemWait(job_system.done);
+	}
+	return used;
+}
@@ -0,0 +1,159 @@
+#include "simple_logger.h"
+
+#include "joint.h"
+
+/**
+ * @brief allocate a joint and fill in what every joint type shares
+ */
+static Joint *joint_new(JointType type, Body *a, Body *b, GFC_Vector2D anchor_a, GFC_Vector2D anchor_b) {
+	Joint *joint;
+	if (!a) {
+		slog("cannot create a joint without a body");
+		return NULL;
+	}
+	joint = gfc_allocate_array(sizeof(Joint), 1);
+	if (!joint) {
+		slog("failed to allocate memory for joint");
+		return NULL;
+	}
+	joint->type = type;
+	joint->a = a;
+	joint->b = b;
+	joint->anchor_a = anchor_a;
+	joint->anchor_b = anchor_b;
+	return joint;
+}
+
+/**
+ * @brief get the world positions of a joint's anchors
+ */
+static void joint_anchors(Joint *self, GFC_Vector2D *a, GFC_Vector2D *b) {
+	gfc_vector2d_add((*a), self->a->position, self->anchor_a);
+	if (self->b) {
+		gfc_vector2d_add((*b), self->b->position, self->anchor_b);
+	} else {
+		*b = self->anchor_b;
+	}
+}
+
+Joint *joint_new_distance(Body *a, Body *b, GFC_Vector2D anchor_a, GFC_Vector2D anchor_b) {
+	GFC_Vector2D pa, pb;
+	Joint *joint = joint_new(JT_DISTANCE, a, b, anchor_a, anchor_b);
+	if (!joint) return NULL;
+	joint_anchors(joint, &pa, &pb);
+	joint->length = gfc_vector2d_magnitude_between(pa, pb);
+	return joint;
+}
+
+Joint *joint_new_pin(Body *a, Body *b, GFC_Vector2D anchor_a, GFC_Vector2D anchor_b) {
+	return joint_new(JT_PIN, a, b, anchor_a, anchor_b);
+}
+
+Joint *joint_new_spring(Body *a, Body *b, GFC_Vector2D anchor_a, GFC_Vector2D anchor_b, float length, float stiffness, float damping) {
+	Joint *joint = joint_new(JT_SPRING, a, b, anchor_a, anchor_b);
+	if (!joint) return NULL;
+	joint->length = MAX(length, 0);
+	joint->stiffness = MAX(stiffness, 0);
+	joint->damping = MAX(damping, 0);
+	return joint;
+}
+
+void joint_free(Joint *self) {
+	if (!self) return;
+	free(self);
+}
+
+/**
+ * @brief apply an impulse to a joint's bodies, pulling b towards a for positive values along the axis
+ */
+static void joint_apply_impulse(Joint *self, GFC_Vector2D impulse) {
+	self->a->velocity.x -= impulse.x * self->a->inv_mass;
+	self->a->velocity.y -= impulse.y * self->a->inv_mass;
+	if (self->b) {
+		self->b->velocity.x += impulse.x * self->b->inv_mass;
+		self->b->velocity.y += impulse.y * self->b->inv_mass;
+	}
+}
+
+void joint_prepare(Joint *self, float delta_time) {
+	GFC_Vector2D pa, pb, delta, impulse;
+	float inv_mass, distance, error, denominator;
+	if (!self) return;
+
+	// Joints only do work while something attached to them is moving
+	self->active = !self->a->sleeping || (self->b && !self->b->sleeping);
+	if (!self->active) {
+		// The bodies stopped at rest, so there is nothing worth warm starting from
+		self->impulse = gfc_vector2d(0, 0);
+		return;
+	}
+	if (self->a->sleeping) body_wake(self->a);
+	if (self->b && self->b->sleeping) body_wake(self->b);
+
+	inv_mass = self->a->inv_mass + (self->b ? self->b->inv_mass : 0);
+	if (inv_mass <= 0 || delta_time <= 0) {
+		self->active = 0;
+		return;
+	}
+
+	joint_anchors(self, &pa, &pb);
+	gfc_vector2d_sub(delta, pb, pa);
+	self->gamma = 0;
+
+	if (self->type == JT_PIN) {
+		// Every direction is constrained and bodies do not rotate, so the effective mass is a scalar
+		self->mass = 1 / inv_mass;
+		gfc_vector2d_scale(self->bias, delta, JOINT_BAUMGARTE / delta_time);
+		joint_apply_impulse(self, self->impulse);
+		return;
+	}
+
+	distance = gfc_vector2d_magnitude(delta);
+	if (distance > GFC_EPSILON) {
+		self->axis = gfc_vector2d(delta.x / distance, delta.y / distance);
+	} else {
+		self->axis = gfc_vector2d(0, 1); // Anchors on top of each other, push straight down
+	}
+	error = distance - self->length;
+
+	if (self->type == JT_SPRING) {
+		// Soft constraint, gamma lets the joint give like a spring instead of snapping back in one step
+		denominator = delta_time * (self->damping + delta_time * self->stiffness);
+		if (denominator <= 0) {
+			self->active = 0;
+			return;
+		}
+		self->gamma = 1 / denominator;
+		self->bias.x = error * delta_time * self->stiffness * self->gamma;
+	} else {
+		self->bias.x = error * JOINT_BAUMGARTE / delta_time;
+	}
+	self->mass = 1 / (inv_mass + self->gamma);
+
+	// Warm start along this step's axis
+	gfc_vector2d_scale(impulse, self->axis, self->impulse.x);
+	joint_apply_impulse(self, impulse);
+}
+
+void joint_solve(Joint *self) {
+	GFC_Vector2D relative, impulse;
+	float lambda;
+	if (!self || !self->active) return;
+
+	// Velocity of b's anchor relative to a's
+	gfc_vector2d_negate(relative, self->a->velocity);
+	if (self->b) gfc_vector2d_add(relative, relative, self->b->velocity);
+
+	if (self->type == JT_PIN) {
+		impulse.x = -self->mass * (relative.x + self->bias.x);
+		impulse.y = -self->mass * (relative.y + self->bias.y);
+		gfc_vector2d_add(self->impulse, self->impulse, impulse);
+		joint_apply_impulse(self, impulse);
+		return;
+	}
+
+	lambda = -self->mass * (gfc_vector2d_dot_product(relative, self->axis) + self->bias.x + self->gamma * self->impulse.x);
+	self->impulse.x += lambda;
+	gfc_vector2d_scale(impulse, self->axis, lambda);
+	joint_apply_impulse(self, impulse);
+}
@@ -0,0 +1,194 @@
+#include "simple_logger.h"
+
+#include "narrowphase.h"
+#include "job.h"
+#include "space.h"
+
+typedef struct {
+	ContactBuffer	*buffers;	// <One contact buffer per job worker
+	Uint32		buffer_count;	// <Number of buffers allocated
+	CollisionPair	*pairs;		// <The pairs being tested
+	Space		*space;		// <The space the pairs came from
+}Narrowphase;
+
+static Narrowphase narrowphase = {0};
+
+typedef struct {
+	Body		*body;		// <The body being tested against the tiles
+	ContactBuffer	*contacts;	// <The buffer the contacts are written to
+	Uint32		grid_width;	// <Width of the tile grid, to turn cells into indices
+}NarrowphaseTileTest;
+
+/**
+ * @brief record a contact between a body and a tile
+ */
+static void narrowphase_push_tile_contact(const TileOverlap *overlap, void *data) {
+	NarrowphaseTileTest *test = data;
+	Contact *contact = contact_buffer_push(test->contacts);
+	if (!contact) return;
+	contact->a = test->body;
+	contact->b = NULL;
+	contact->shape = COLLISION_TILE_SHAPE | (overlap->y * test->grid_width + overlap->x);
+	contact->poc = overlap->poc;
+	contact->normal = overlap->normal;
+	contact->depth = overlap->depth;
+}
+
+/**
+ * @brief test a body against every tile its bounds cover
+ * @param space the space whose tile grid is tested
+ * @param body the body being tested
+ * @param collider the body's collider in world space
+ * @param contacts the buffer the contacts are written to
+ */
+static void narrowphase_test_tiles(Space *space, Body *body, GFC_Shape collider, ContactBuffer *contacts) {
+	NarrowphaseTileTest test;
+	TileOverlap overlap = {0};
+	GFC_Rect bounds;
+	Sint32 x, y, x1, y1;
+	test.body = body;
+	test.contacts = contacts;
+	test.grid_width = space->grid_width;
+
+	// Circles go through the batched kernel
+	if (collider.type == ST_CIRCLE) {
+		space_overlap_circle_tiles(space, collider.s.c, narrowphase_push_tile_contact, &test);
+		return;
+	}
+
+	// Anything else is tested a tile at a time, one way tiles only hold up circles
+	bounds = collision_shape_bounds(collider);
+	x1 = MIN((Sint32)floor((bounds.x + bounds.w) / space->tile_size), (Sint32)space->grid_width - 1);
+	y1 = MIN((Sint32)floor((bounds.y + bounds.h) / space->tile_size), (Sint32)space->grid_height - 1);
+	for (y = MAX((Sint32)floor(bounds.y / space->tile_size), 0); y <= y1; ++y) {
+		for (x = MAX((Sint32)floor(bounds.x / space->tile_size), 0); x <= x1; ++x) {
+			overlap.tile = space_get_solid_tile(space, x, y);
+			if (!overlap.tile || overlap.tile->collision_type == TCT_ONE_WAY) continue;
+			if (!gfc_shape_overlap_poc(gfc_shape_from_rect(space_get_tile_rect(space, overlap.tile, x, y)), collider, &overlap.poc, &overlap.normal)) continue;
+			overlap.x = x;
+			overlap.y = y;
+			narrowphase_push_tile_contact(&overlap, &test);
+		}
+	}
+}
+
+/**
+ * @brief test a single pair and record a contact if the shapes overlap
+ * @param space the space whose static shapes and tile grid the pair may refer to
+ * @param pair the pair to be tested
+ * @param contacts the buffer the contact is written to
+ */
+static void narrowphase_test_pair(Space *space, CollisionPair *pair, ContactBuffer *contacts) {
+	GFC_Shape a, b;
+	GFC_Shape *shape;
+	GFC_Vector2D poc, normal, delta;
+	float distance, radii;
+	Contact *contact;
+
+	a = body_world_collider(pair->a);
+	if (pair->b) {
+		b = body_world_collider(pair->b);
+
+		// Circles are the common case between bodies, so resolve them directly
+		if (a.type == ST_CIRCLE && b.type == ST_CIRCLE) {
+			delta = gfc_vector2d(a.s.c.x - b.s.c.x, a.s.c.y - b.s.c.y);
+			radii = a.s.c.r + b.s.c.r;
+			if (gfc_vector2d_magnitude_squared(delta) >= radii * radii) return;
+
+			distance = gfc_vector2d_magnitude(delta);
+			if (distance > 0) {
+				normal = gfc_vector2d(delta.x / distance, delta.y / distance);
+			} else {
+				normal = gfc_vector2d(0, -1); // Perfectly stacked, push straight up
+			}
+
+			contact = contact_buffer_push(contacts);
+			if (!contact) return;
+			contact->a = pair->a;
+			contact->b = pair->b;
+			contact->shape = -1;
+			contact->normal = normal;
+			contact->poc = gfc_vector2d(b.s.c.x + normal.x * b.s.c.r, b.s.c.y + normal.y * b.s.c.r);
+			contact->depth = radii - distance;
+			return;
+		}
+	} else if (pair->shape == BROADPHASE_TILE_GRID) {
+		narrowphase_test_tiles(space, pair->a, a, contacts);
+		return;
+	} else {
+		shape = gfc_list_get_nth(space->static_shapes, pair->shape);
+		if (!shape) return;
+		b = *shape;
+	}
+
+	if (!gfc_shape_overlap_poc(b, a, &poc, &normal)) return;
+
+	contact = contact_buffer_push(contacts);
+	if (!contact) return;
+	contact->a = pair->a;
+	contact->b = pair->b;
+	contact->shape = pair->shape;
+	contact->poc = poc;
+	contact->normal = normal;
+	if (a.type == ST_CIRCLE) {
+		contact->depth = a.s.c.r - gfc_vector2d_magnitude_between(poc, gfc_vector2d(a.s.c.x, a.s.c.y));
+	}
+}
+
+/**
+ * @brief job that tests a range of pairs into the worker's own buffer
+ */
+static void narrowphase_job(Uint32 begin, Uint32 end, Uint32 worker, void *data) {
+	Uint32 i;
+	ContactBuffer *contacts = &narrowphase.buffers[worker];
+	contact_buffer_clear(contacts);
+	for (i = begin; i < end; ++i) {
+		narrowphase_test_pair(narrowphase.space, &narrowphase.pairs[i], contacts);
+	}
+}
+
+/**
+ * @brief free the per worker contact buffers
+ */
+void narrowphase_close() {
+	Uint32 i;
+	for (i = 0; i < narrowphase.buffer_count; ++i) {
+		contact_buffer_free(&narrowphase.buffers[i]);
+	}
+	if (narrowphase.buffers) free(narrowphase.buffers);
+	memset(&narrowphase, 0, sizeof(Narrowphase));
+}
+
+void narrowphase_init() {
+	Uint32 count = job_system_worker_count();
+	if (narrowphase.buffers) return;
+	narrowphase.buffers = gfc_allocate_array(sizeof(ContactBuffer), count);
+	if (!narrowphase.buffers) {
+		slog("failed to allocate %i narrowphase contact buffers", count);
+		return;
+	}
+	narrowphase.buffer_count = count;
+	atexit(narrowphase_close);
+}
+
+void narrowphase_run(Space *space, CollisionPair *pairs, Uint32 pair_count, ContactBuffer *contacts) {
+	Uint32 i, used;
+	if (!contacts) return;
+	contact_buffer_clear(contacts);
+	if (!space || !pairs || !pair_count) return;
+	if (narrowphase.buffer_count < job_system_worker_count()) {
+		// The job system was started after the buffers were made
+		narrowphase_close();
+	}
+	if (!narrowphase.buffers) narrowphase_init();
+	if (!narrowphase.buffers) return;
+
+	narrowphase.pairs = pairs;
+	narrowphase.space = space;
+	used = job_system_run(pair_count, NARROWPHASE_MIN_PAIRS_PER_THREAD, narrowphase_job, NULL);
+
+	// Merge in range order so the result matches a single threaded run
+	for (i = 0; i < used; ++i) {
+		contact_buffer_append(contacts, &narrowphase.buffers[i]);
+	}
+}
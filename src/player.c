@@ -7,7 +7,7 @@
 
 #include "gf2d_graphics.h"
 #include "gf2d_sprite.h"
-#include "gf2d_draw.h"
+#include "gf2d_debug_draw.h"
 
 #include "player.h"
 #include "bug.h"
@@ -42,47 +42,22 @@ void player_update(Entity *self) {
 	}
 
 	if (gfc_input_command_pressed("shoot1")) {
-		Entity *bug = bug_new_entity(self->position, "./def/bugs/bug1.def");
-		bug->velocity = gfc_vector2d(projv1, 0);
+		Entity *bug = bug_new_entity(self->position, "./def/bugs/bug1.def", self);
+		if (bug) bug->velocity = gfc_vector2d(projv1, 0);
 	}
 
 	if (gfc_input_command_pressed("shoot2")) {
-		Entity *bug = bug_new_entity(self->position, "./def/bugs/bug2.def");
-		bug->velocity = gfc_vector2d(0, projv2);
+		Entity *bug = bug_new_entity(self->position, "./def/bugs/bug2.def", self);
+		if (bug) bug->velocity = gfc_vector2d(0, projv2);
 	}
 	
 	gfc_vector2d_normalize(&self->velocity);
 	gfc_vector2d_scale_by(self->velocity, self->velocity, gfc_vector2d(1, 1));
 
 
-	//gfc_vector2d_add(self->position, self->position, self->velocity);
-
-	GFC_List *collision_list = space_overlap_entity_static_shape(world_get_active()->space, self);
-	if (collision_list) {
-		int i, c;
-		c = gfc_list_count(collision_list);
-		for (i = 0; i < c; ++i) {
-			Collision *curr = ((Collision*)gfc_list_get_nth(collision_list, i));
-			slog("Point of collision %i: (%f, %f)", i, curr->poc.x, curr->poc.y);
-			
-			//
-			GFC_Vector2D center_worldspace;
-			gfc_vector2d_add(center_worldspace, self->position, gfc_vector2d(self->collider.x, self->collider.y));
-			if (gfc_vector2d_distance_between_less_than(center_worldspace, curr->poc, self->collider.r)) {
-				GFC_Vector2D scaled_normal, distance_vector;
-				float distance = gfc_vector2d_magnitude_between(curr->poc, center_worldspace);
-				float correction = self->collider.r - distance;
-				gfc_vector2d_copy(scaled_normal, curr->normal);
-				gfc_vector2d_scale_by(scaled_normal, scaled_normal, gfc_vector2d(correction, correction));
-				//gfc_vector2d_add(self->position, self->position, scaled_normal);
-			}
-		}
-
-		
-		// Reassign for draw call
-		if (DRAW_COLLISIONS) {
-			player_collision_list = collision_list;
-		}
+	// The player's character controller slides it along the tiles, the contacts are only needed for debug drawing
+	if (DRAW_COLLISIONS) {
+		player_collision_list = space_overlap_entity_static_shape(world_get_active()->space, self);
 	}
 
 	slog("player think");
@@ -108,8 +83,8 @@ void player_draw(Entity *self) {
 			gfc_vector2d_scale_by(normalendpos, curr->normal, gfc_vector2d(10, 10));
 			gfc_vector2d_add(normalenddrawpos, curr->poc, normalendpos);
 			normalenddrawpos = main_camera_calc_drawpos(normalenddrawpos);
-			gf2d_draw_circle(drawpos, 4, GFC_COLOR_BLUE);
-			gf2d_draw_line(drawpos, normalenddrawpos, GFC_COLOR_BLUE);
+			gf2d_debug_draw_circle(drawpos, 4, GFC_COLOR_BLUE);
+			gf2d_debug_draw_line(drawpos, normalenddrawpos, GFC_COLOR_BLUE);
 			slog("drawn");
 		}
 		
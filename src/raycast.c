@@ -0,0 +1,304 @@
+#include <float.h>
+
+#include "simple_logger.h"
+
+#include "raycast.h"
+
+/**
+ * @brief the traversal state of a ray walking the tile grid
+ */
+typedef struct {
+	Sint32		x, y;		// <The current cell
+	Sint32		step_x, step_y;	// <Which way the cell index moves on each axis
+	float		t_max_x;	// <Distance at which the ray crosses the next column boundary
+	float		t_max_y;	// <Distance at which the ray crosses the next row boundary
+	float		t_delta_x;	// <Distance between column boundaries along the ray
+	float		t_delta_y;	// <Distance between row boundaries along the ray
+	float		t;		// <Distance at which the ray entered the current cell
+	float		t_end;		// <Distance at which the walk stops
+	Sint32		margin;		// <How many cells outside the grid the walk may visit
+}GridWalk;
+
+/**
+ * @brief intersect a ray with a rect using the slab method
+ * @param origin the start of the ray
+ * @param dir the normalized direction of the ray
+ * @param rect the rect being tested
+ * @param t_enter receives the distance at which the ray enters the rect
+ * @param t_exit receives the distance at which the ray leaves the rect
+ * @param normal (optional) receives the normal of the face the ray enters through
+ * @return 1 if the ray's line crosses the rect, 0 otherwise
+ */
+static Uint8 raycast_slab(GFC_Vector2D origin, GFC_Vector2D dir, GFC_Rect rect, float *t_enter, float *t_exit, GFC_Vector2D *normal) {
+	float tx1, tx2, ty1, ty2, tmin_x, tmax_x, tmin_y, tmax_y;
+
+	if (dir.x != 0) {
+		tx1 = (rect.x - origin.x) / dir.x;
+		tx2 = (rect.x + rect.w - origin.x) / dir.x;
+		tmin_x = MIN(tx1, tx2);
+		tmax_x = MAX(tx1, tx2);
+	} else {
+		if (origin.x < rect.x || origin.x > rect.x + rect.w) return 0;
+		tmin_x = -FLT_MAX;
+		tmax_x = FLT_MAX;
+	}
+	if (dir.y != 0) {
+		ty1 = (rect.y - origin.y) / dir.y;
+		ty2 = (rect.y + rect.h - origin.y) / dir.y;
+		tmin_y = MIN(ty1, ty2);
+		tmax_y = MAX(ty1, ty2);
+	} else {
+		if (origin.y < rect.y || origin.y > rect.y + rect.h) return 0;
+		tmin_y = -FLT_MAX;
+		tmax_y = FLT_MAX;
+	}
+
+	*t_enter = MAX(tmin_x, tmin_y);
+	*t_exit = MIN(tmax_x, tmax_y);
+	if (*t_enter > *t_exit) return 0;
+
+	if (normal) {
+		if (tmin_x > tmin_y) *normal = gfc_vector2d(dir.x > 0 ? -1 : 1, 0);
+		else *normal = gfc_vector2d(0, dir.y > 0 ? -1 : 1);
+	}
+	return 1;
+}
+
+/**
+ * @brief intersect a ray with a circle
+ * @return 1 if the ray hits the circle at a distance of at least 0, with the distance in t
+ */
+static Uint8 raycast_circle(GFC_Vector2D origin, GFC_Vector2D dir, GFC_Vector2D center, float radius, float *t) {
+	GFC_Vector2D m;
+	float b, c, disc;
+	gfc_vector2d_sub(m, origin, center);
+	b = gfc_vector2d_dot_product(m, dir);
+	c = gfc_vector2d_dot_product(m, m) - radius * radius;
+	if (c > 0 && b > 0) return 0;
+	disc = b * b - c;
+	if (disc < 0) return 0;
+	*t = MAX(-b - sqrt(disc), 0);
+	return 1;
+}
+
+/**
+ * @brief test a ray against a single tile, respecting one way tiles
+ * @param t receives the hit distance
+ * @param normal receives the hit normal
+ * @return 1 on a hit at a distance between 0 and max_distance
+ */
+static Uint8 raycast_test_tile(Space *self, TileData *data, Sint32 x, Sint32 y, GFC_Vector2D origin, GFC_Vector2D dir, float max_distance, float *t, GFC_Vector2D *normal) {
+	float t_enter, t_exit;
+	if (!raycast_slab(origin, dir, space_get_tile_rect(self, data, x, y), &t_enter, &t_exit, normal)) return 0;
+	if (t_exit < 0 || t_enter > max_distance) return 0;
+	if (t_enter < 0) return 0; // Rays starting inside a tile pass out of it
+
+	// One way tiles only block things coming down onto them
+	if (data->collision_type == TCT_ONE_WAY && normal->y >= 0) return 0;
+
+	*t = t_enter;
+	return 1;
+}
+
+/**
+ * @brief test a circle sweep against a single tile, respecting one way tiles
+ * @param t receives the hit distance
+ * @param normal receives the hit normal
+ * @return 1 on a hit at a distance between 0 and max_distance
+ */
+static Uint8 raycast_test_tile_circle(Space *self, TileData *data, Sint32 x, Sint32 y, GFC_Vector2D origin, float radius, GFC_Vector2D dir, float max_distance, float *t, GFC_Vector2D *normal) {
+	GFC_Rect rect, expanded;
+	GFC_Vector2D point, corner;
+	float t_enter, t_exit, t_corner;
+
+	rect = space_get_tile_rect(self, data, x, y);
+	expanded = gfc_rect(rect.x - radius, rect.y - radius, rect.w + radius * 2, rect.h + radius * 2);
+	if (!raycast_slab(origin, dir, expanded, &t_enter, &t_exit, normal)) return 0;
+	if (t_exit < 0 || t_enter > max_distance) return 0;
+
+	// Already overlapping, only block movement further into the tile
+	if (t_enter < 0) {
+		corner = gfc_vector2d(
+			MAX(rect.x, MIN(origin.x, rect.x + rect.w)),
+			MAX(rect.y, MIN(origin.y, rect.y + rect.h)));
+		gfc_vector2d_sub(point, origin, corner);
+		if (gfc_vector2d_magnitude_squared(point) > radius * radius) {
+			// Only inside the rounded off corner of the expanded rect, fall through to the corner test
+			t_enter = 0;
+		} else {
+			if (point.x == 0 && point.y == 0) return 0; // Center inside the tile, let it move out
+			gfc_vector2d_normalize(&point);
+			if (gfc_vector2d_dot_product(point, dir) >= 0) return 0;
+			if (data->collision_type == TCT_ONE_WAY) return 0;
+			*normal = point;
+			*t = 0;
+			return 1;
+		}
+	}
+
+	// Hits on the corners of the expanded rect are really hits on the rounded corners
+	point = gfc_vector2d(origin.x + dir.x * t_enter, origin.y + dir.y * t_enter);
+	if ((point.x < rect.x || point.x > rect.x + rect.w) && (point.y < rect.y || point.y > rect.y + rect.h)) {
+		corner = gfc_vector2d(point.x < rect.x ? rect.x : rect.x + rect.w, point.y < rect.y ? rect.y : rect.y + rect.h);
+		if (!raycast_circle(origin, dir, corner, radius, &t_corner)) return 0;
+		if (t_corner > max_distance) return 0;
+		t_enter = t_corner;
+		point = gfc_vector2d(origin.x + dir.x * t_enter - corner.x, origin.y + dir.y * t_enter - corner.y);
+		gfc_vector2d_normalize(&point);
+		*normal = point;
+	}
+
+	// One way tiles only block things coming down onto their top
+	if (data->collision_type == TCT_ONE_WAY && (normal->y >= 0 || origin.y + radius > rect.y)) return 0;
+
+	*t = t_enter;
+	return 1;
+}
+
+/**
+ * @brief set up a walk of the tile grid along a ray, clipped to the grid's bounds
+ * @param walk receives the traversal state
+ * @param dir the normalized direction of the ray
+ * @param margin how many cells the grid's bounds are grown by, so wide casts can start outside of it
+ * @return 0 if the ray never enters the grid
+ */
+static Uint8 raycast_walk_begin(Space *self, GridWalk *walk, GFC_Vector2D origin, GFC_Vector2D dir, float max_distance, Sint32 margin) {
+	float t_enter, t_exit, ts = self->tile_size;
+	GFC_Vector2D start;
+	GFC_Rect grid = gfc_rect(-margin * ts, -margin * ts, (self->grid_width + margin * 2) * ts, (self->grid_height + margin * 2) * ts);
+
+	if (!raycast_slab(origin, dir, grid, &t_enter, &t_exit, NULL)) return 0;
+	t_enter = MAX(t_enter, 0);
+	walk->t_end = MIN(t_exit, max_distance);
+	if (t_enter > walk->t_end) return 0;
+
+	start = gfc_vector2d(origin.x + dir.x * t_enter, origin.y + dir.y * t_enter);
+	walk->t = t_enter;
+	walk->margin = margin;
+	walk->x = MIN(MAX((Sint32)floor(start.x / ts), -margin), (Sint32)self->grid_width - 1 + margin);
+	walk->y = MIN(MAX((Sint32)floor(start.y / ts), -margin), (Sint32)self->grid_height - 1 + margin);
+
+	walk->step_x = (dir.x > 0) ? 1 : ((dir.x < 0) ? -1 : 0);
+	walk->step_y = (dir.y > 0) ? 1 : ((dir.y < 0) ? -1 : 0);
+	walk->t_delta_x = walk->step_x ? ts / fabs(dir.x) : FLT_MAX;
+	walk->t_delta_y = walk->step_y ? ts / fabs(dir.y) : FLT_MAX;
+	walk->t_max_x = walk->step_x ? ((walk->x + (walk->step_x > 0)) * ts - origin.x) / dir.x : FLT_MAX;
+	walk->t_max_y = walk->step_y ? ((walk->y + (walk->step_y > 0)) * ts - origin.y) / dir.y : FLT_MAX;
+	return 1;
+}
+
+/**
+ * @brief move a grid walk into the next cell along the ray
+ * @return 0 once the walk leaves the grid or passes its end distance
+ */
+static Uint8 raycast_walk_next(Space *self, GridWalk *walk) {
+	if (walk->t_max_x < walk->t_max_y) {
+		walk->x += walk->step_x;
+		walk->t = walk->t_max_x;
+		walk->t_max_x += walk->t_delta_x;
+	} else {
+		walk->y += walk->step_y;
+		walk->t = walk->t_max_y;
+		walk->t_max_y += walk->t_delta_y;
+	}
+	if (walk->t > walk->t_end) return 0;
+	if (walk->x < -walk->margin || walk->y < -walk->margin) return 0;
+	if (walk->x >= (Sint32)self->grid_width + walk->margin || walk->y >= (Sint32)self->grid_height + walk->margin) return 0;
+	return 1;
+}
+
+/**
+ * @brief normalize a ray direction
+ * @return 0 if the direction has no length
+ */
+static Uint8 raycast_direction(GFC_Vector2D *direction) {
+	if (direction->x == 0 && direction->y == 0) return 0;
+	gfc_vector2d_normalize(direction);
+	return 1;
+}
+
+Uint8 space_raycast(Space *self, GFC_Vector2D origin, GFC_Vector2D direction, float max_distance, RaycastHit *hit) {
+	GridWalk walk;
+	TileData *data;
+	GFC_Vector2D normal;
+	float t;
+
+	if (hit) memset(hit, 0, sizeof(RaycastHit));
+	if (!self || !self->tile_map || self->tile_size <= 0) return 0;
+	if (!raycast_direction(&direction)) return 0;
+	if (!raycast_walk_begin(self, &walk, origin, direction, max_distance, 0)) return 0;
+
+	// Tiles never reach outside their cell, so the first hit in walk order is the nearest
+	do {
+		data = space_get_solid_tile(self, walk.x, walk.y);
+		if (!data) continue;
+		if (!raycast_test_tile(self, data, walk.x, walk.y, origin, direction, max_distance, &t, &normal)) continue;
+
+		if (hit) {
+			hit->hit = 1;
+			hit->distance = t;
+			hit->point = gfc_vector2d(origin.x + direction.x * t, origin.y + direction.y * t);
+			hit->normal = normal;
+			hit->tile_x = walk.x;
+			hit->tile_y = walk.y;
+		}
+		return 1;
+	} while (raycast_walk_next(self, &walk));
+
+	return 0;
+}
+
+Uint8 space_circle_cast(Space *self, GFC_Vector2D origin, float radius, GFC_Vector2D direction, float max_distance, RaycastHit *hit) {
+	GridWalk walk;
+	TileData *data;
+	GFC_Vector2D normal, best_normal = {0};
+	Sint32 x, y, reach, best_x = 0, best_y = 0;
+	float t, best = FLT_MAX;
+	Uint8 found = 0;
+
+	if (hit) memset(hit, 0, sizeof(RaycastHit));
+	if (!self || !self->tile_map || self->tile_size <= 0) return 0;
+	if (!raycast_direction(&direction)) return 0;
+
+	// Walk the center's path, testing every cell within a radius of each visited cell
+	reach = (Sint32)ceil(radius / self->tile_size);
+	if (!raycast_walk_begin(self, &walk, origin, direction, max_distance, reach)) return 0;
+
+	do {
+		// Any tile hit later than this cell's entry would have been found in an earlier cell
+		if (walk.t > best) break;
+
+		for (y = walk.y - reach; y <= walk.y + reach; ++y) {
+			for (x = walk.x - reach; x <= walk.x + reach; ++x) {
+				data = space_get_solid_tile(self, x, y);
+				if (!data) continue;
+				if (!raycast_test_tile_circle(self, data, x, y, origin, radius, direction, max_distance, &t, &normal)) continue;
+				if (t >= best) continue;
+				best = t;
+				best_normal = normal;
+				best_x = x;
+				best_y = y;
+				found = 1;
+			}
+		}
+	} while (raycast_walk_next(self, &walk));
+
+	if (found && hit) {
+		hit->hit = 1;
+		hit->distance = best;
+		hit->point = gfc_vector2d(origin.x + direction.x * best, origin.y + direction.y * best);
+		hit->normal = best_normal;
+		hit->tile_x = best_x;
+		hit->tile_y = best_y;
+	}
+	return found;
+}
+
+Uint32 space_raycast_batch(Space *self, const Ray *rays, Uint32 count, RaycastHit *hits) {
+	Uint32 i, hit_count = 0;
+	if (!rays || !hits) return 0;
+	for (i = 0; i < count; ++i) {
+		hit_count += space_raycast(self, rays[i].origin, rays[i].direction, rays[i].max_distance, &hits[i]);
+	}
+	return hit_count;
+}
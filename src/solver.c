@@ -0,0 +1,198 @@
+#include "simple_logger.h"
+
+#include "solver.h"
+#include "job.h"
+
+/**
+ * @brief get the inverse mass a body has for this solve
+ * @note sleeping bodies are not integrated, so they are solved as immovable rather than building up motion
+ */
+static float solver_body_inv_mass(Body *body) {
+	if (!body || body->sleeping) return 0;
+	return body->inv_mass;
+}
+
+/**
+ * @brief apply an impulse along a contact's normal to both bodies
+ * @param contact the contact being resolved
+ * @param impulse the impulse magnitude, positive pushes the bodies apart
+ */
+static void solver_apply_impulse(Contact *contact, float impulse) {
+	GFC_Vector2D p;
+	float inv_a = solver_body_inv_mass(contact->a), inv_b = solver_body_inv_mass(contact->b);
+	gfc_vector2d_scale(p, contact->normal, impulse);
+	contact->a->velocity.x += p.x * inv_a;
+	contact->a->velocity.y += p.y * inv_a;
+	if (contact->b) {
+		contact->b->velocity.x -= p.x * inv_b;
+		contact->b->velocity.y -= p.y * inv_b;
+	}
+}
+
+/**
+ * @brief get the combined inverse mass of a contact's bodies
+ */
+static float solver_inv_mass(Contact *contact) {
+	return solver_body_inv_mass(contact->a) + solver_body_inv_mass(contact->b);
+}
+
+void solver_solve_contacts(ContactBuffer *contacts, ContactCache *cache, Uint32 iterations) {
+	Uint32 i, j;
+	Contact *contact;
+	ContactCacheEntry *entry;
+	GFC_Vector2D relative;
+	float inv_mass, vn, impulse, correction;
+	if (!contacts || !contacts->count) return;
+
+	// Warm start from the impulses accumulated last time the pairs were solved
+	for (i = 0; i < contacts->count; ++i) {
+		contact = &contacts->contacts[i];
+		entry = contact_cache_get(cache, contact_key(contact), 1);
+		contact->impulse = entry ? entry->impulse : 0;
+		if (contact->impulse > 0) solver_apply_impulse(contact, contact->impulse);
+	}
+
+	// Sequential impulses, clamping the accumulated impulse so contacts only push
+	for (j = 0; j < iterations; ++j) {
+		for (i = 0; i < contacts->count; ++i) {
+			contact = &contacts->contacts[i];
+			inv_mass = solver_inv_mass(contact);
+			if (inv_mass <= 0) continue;
+
+			relative = contact->a->velocity;
+			if (contact->b) gfc_vector2d_sub(relative, relative, contact->b->velocity);
+			vn = gfc_vector2d_dot_product(relative, contact->normal);
+
+			impulse = MAX(contact->impulse - vn / inv_mass, 0);
+			solver_apply_impulse(contact, impulse - contact->impulse);
+			contact->impulse = impulse;
+		}
+	}
+
+	// Store the results for next time and push the bodies out of each other
+	for (i = 0; i < contacts->count; ++i) {
+		contact = &contacts->contacts[i];
+		entry = contact_cache_get(cache, contact_key(contact), 0);
+		if (entry) entry->impulse = contact->impulse;
+
+		inv_mass = solver_inv_mass(contact);
+		if (inv_mass <= 0 || contact->depth <= SOLVER_SLOP) continue;
+		correction = (contact->depth - SOLVER_SLOP) * SOLVER_CORRECTION / inv_mass;
+		contact->a->position.x += contact->normal.x * correction * solver_body_inv_mass(contact->a);
+		contact->a->position.y += contact->normal.y * correction * solver_body_inv_mass(contact->a);
+		if (contact->b) {
+			contact->b->position.x -= contact->normal.x * correction * solver_body_inv_mass(contact->b);
+			contact->b->position.y -= contact->normal.y * correction * solver_body_inv_mass(contact->b);
+		}
+	}
+}
+
+/**
+ * @brief get the colors already taken by joints on a body
+ */
+static Uint64 solver_body_colors(Body *body) {
+	return body ? body->joint_colors : 0;
+}
+
+void solver_color_joints(JointBatches *batches, GFC_List *joints) {
+	Uint32 i, c, color;
+	Uint32 counts[SOLVER_JOINT_COLORS + 1] = {0};
+	Uint64 used;
+	Joint *joint;
+	Joint **grown;
+	if (!batches) return;
+	batches->dirty = 0;
+	batches->batch_count = 0;
+	batches->joint_count = 0;
+	c = gfc_list_count(joints);
+	if (!c) return;
+
+	if (c > batches->joint_capacity) {
+		grown = gfc_allocate_array(sizeof(Joint *), c);
+		if (!grown) {
+			slog("failed to allocate joint batches for %i joints", c);
+			return;
+		}
+		if (batches->joints) free(batches->joints);
+		batches->joints = grown;
+		batches->joint_capacity = c;
+	}
+
+	// Clear the colors on every body the joints touch
+	for (i = 0; i < c; ++i) {
+		joint = gfc_list_get_nth(joints, i);
+		if (!joint) continue;
+		joint->a->joint_colors = 0;
+		if (joint->b) joint->b->joint_colors = 0;
+	}
+
+	// Greedy coloring, each joint takes the lowest color neither body has yet
+	for (i = 0; i < c; ++i) {
+		joint = gfc_list_get_nth(joints, i);
+		if (!joint) continue;
+		used = solver_body_colors(joint->a) | solver_body_colors(joint->b);
+		for (color = 0; color < SOLVER_JOINT_COLORS; ++color) {
+			if (!(used & ((Uint64)1 << color))) break;
+		}
+		joint->color = color;
+		counts[color]++;
+		if (color == SOLVER_JOINT_COLORS) continue; // Serial batch, does not claim a color
+		joint->a->joint_colors |= (Uint64)1 << color;
+		if (joint->b) joint->b->joint_colors |= (Uint64)1 << color;
+	}
+
+	// Counting sort the joints into contiguous batches, skipping empty colors
+	batches->batch_start[0] = 0;
+	for (color = 0; color <= SOLVER_JOINT_COLORS; ++color) {
+		if (!counts[color]) continue;
+		batches->batch_start[batches->batch_count + 1] = batches->batch_start[batches->batch_count] + counts[color];
+		counts[color] = batches->batch_start[batches->batch_count]; // Reused as the batch's write position
+		batches->batch_count++;
+	}
+	for (i = 0; i < c; ++i) {
+		joint = gfc_list_get_nth(joints, i);
+		if (!joint) continue;
+		batches->joints[counts[joint->color]++] = joint;
+	}
+	batches->joint_count = batches->batch_start[batches->batch_count];
+}
+
+/**
+ * @brief job that runs one iteration over a range of a batch
+ */
+static void solver_joint_job(Uint32 begin, Uint32 end, Uint32 worker, void *data) {
+	Joint **joints = data;
+	Uint32 i;
+	for (i = begin; i < end; ++i) {
+		joint_solve(joints[i]);
+	}
+}
+
+void solver_solve_joints(JointBatches *batches, Uint32 iterations, float delta_time) {
+	Uint32 i, j, begin, count;
+	if (!batches || !batches->joint_count) return;
+
+	for (i = 0; i < batches->joint_count; ++i) {
+		joint_prepare(batches->joints[i], delta_time);
+	}
+
+	for (j = 0; j < iterations; ++j) {
+		for (i = 0; i < batches->batch_count; ++i) {
+			begin = batches->batch_start[i];
+			count = batches->batch_start[i + 1] - begin;
+
+			// Joints in the serial batch can share bodies, so they stay on this thread
+			if (batches->joints[begin]->color == SOLVER_JOINT_COLORS) {
+				solver_joint_job(0, count, 0, &batches->joints[begin]);
+				continue;
+			}
+			job_system_run(count, SOLVER_JOINTS_PER_WORKER, solver_joint_job, &batches->joints[begin]);
+		}
+	}
+}
+
+void solver_joint_batches_free(JointBatches *batches) {
+	if (!batches) return;
+	if (batches->joints) free(batches->joints);
+	memset(batches, 0, sizeof(JointBatches));
+}
@@ -2,12 +2,15 @@
 
 #include "gfc_color.h"
 
-#include "gf2d_draw.h"
+#include "gf2d_debug_draw.h"
 #include "gf2d_graphics.h"
 
 #include "camera.h"
 #include "space.h"
 #include "collision.h"
+#include "narrowphase.h"
+#include "solver.h"
+#include "character.h"
 
 /*
 typedef struct {
@@ -36,6 +39,24 @@ Space* space_new() {
 
 	// Create the body shape list
 	space->bodies = gfc_list_new();
+	space->static_layer = BL_WORLD;
+
+	// Create the trigger list
+	space->triggers = gfc_list_new();
+
+	// Create the joint list
+	space->joints = gfc_list_new();
+
+	// Default sleep config
+	space->sleep_velocity = SPACE_SLEEP_VELOCITY;
+	space->sleep_steps = SPACE_SLEEP_STEPS;
+
+	// Default substep config
+	space->max_substeps = SPACE_MAX_SUBSTEPS;
+
+	// Default solver config
+	space->solver_iterations = SOLVER_ITERATIONS;
+	space->joint_iterations = SOLVER_JOINT_ITERATIONS;
 
 	return space;
 }
@@ -48,14 +69,37 @@ void space_free(Space *self) {
 		free(gfc_list_get_nth(self->static_shapes, i));
 	}
 
-	// Free the list of bodies
+	// Free the list of bodies, detaching them first so they do not remove themselves from the list
 	list_count = gfc_list_get_count(self->bodies);
 	for (i = 0; i < list_count; ++i) {
-		body_free(gfc_list_get_nth(self->bodies, i));
+		Body *body = gfc_list_get_nth(self->bodies, i);
+		if (!body) continue;
+		body->space = NULL;
+		body_free(body);
+	}
+
+	// Free the triggers
+	list_count = gfc_list_get_count(self->triggers);
+	for (i = 0; i < list_count; ++i) {
+		trigger_free(gfc_list_get_nth(self->triggers, i));
+	}
+
+	// Free the joints
+	list_count = gfc_list_get_count(self->joints);
+	for (i = 0; i < list_count; ++i) {
+		joint_free(gfc_list_get_nth(self->joints, i));
 	}
 
 	gfc_list_delete(self->static_shapes);
 	gfc_list_delete(self->bodies);
+	gfc_list_delete(self->triggers);
+	gfc_list_delete(self->joints);
+
+	// Free the collision detection buffers
+	broadphase_free(&self->broadphase);
+	contact_buffer_free(&self->contacts);
+	contact_cache_free(&self->contact_cache);
+	solver_joint_batches_free(&self->joint_batches);
 	free(self);	
 }
 
@@ -69,11 +113,15 @@ void space_add_static_shape(Space *self, GFC_Shape shape) {
 }
 
 /**
- * @brief for debugging purposes, draws all static shapes in the space
+ * @brief for debugging purposes, draws all static shapes and solid tiles in the space
  */
 void space_draw(Space *self) {
 	Uint32 i, count;
+	Sint32 x, y, x0, y0, x1, y1;
 	GFC_Shape *curr;
+	TileData *tile;
+	GFC_Rect rect;
+	GFC_Rect view = main_camera_get_view();
 	count = gfc_list_get_count(self->static_shapes);
 
 	GFC_Vector2D screen_res = gf2d_graphics_get_resolution();
@@ -86,12 +134,13 @@ void space_draw(Space *self) {
 		GFC_Vector2D draw_pos = {0};
 
 		if (curr->type == ST_RECT) {
+			if (!gfc_rect_overlap(curr->s.r, view)) continue;
 			gfc_vector2d_add(draw_pos, gfc_vector2d(curr->s.r.x, curr->s.r.y), main_camera_get_offset());
 			gfc_vector2d_scale_by(draw_pos, draw_pos, scale);
 			gfc_vector2d_add(draw_pos, draw_pos, screen_res);
 
 			GFC_Rect rect = gfc_rect(draw_pos.x, draw_pos.y, scale.x * curr->s.r.w, scale.y * curr->s.r.h);
-			gf2d_draw_rect(rect, GFC_COLOR_LIGHTGREEN);
+			gf2d_debug_draw_rect(rect, GFC_COLOR_LIGHTGREEN);
 			
 		} else if (curr->type == ST_CIRCLE) {
 			// TODO implement drawing the circle
@@ -102,6 +151,38 @@ void space_draw(Space *self) {
 		}
 
 	}
+
+	// Draw the solid tiles of the grid, only visiting the cells in view
+	if (!self->tile_map || self->tile_size <= 0) return;
+	// Collision boxes start at their cell's corner, so one cell up and left can still reach into view
+	x0 = MAX((Sint32)floor(view.x / self->tile_size) - 1, 0);
+	y0 = MAX((Sint32)floor(view.y / self->tile_size) - 1, 0);
+	x1 = MIN((Sint32)floor((view.x + view.w) / self->tile_size), (Sint32)self->grid_width - 1);
+	y1 = MIN((Sint32)floor((view.y + view.h) / self->tile_size), (Sint32)self->grid_height - 1);
+	for (y = y0; y <= y1; ++y) {
+		for (x = x0; x <= x1; ++x) {
+			tile = space_get_solid_tile(self, x, y);
+			if (!tile) continue;
+			rect = space_get_tile_rect(self, tile, x, y);
+			GFC_Vector2D scale = main_camera_get_zoom();
+			GFC_Vector2D draw_pos = {0};
+			gfc_vector2d_add(draw_pos, gfc_vector2d(rect.x, rect.y), main_camera_get_offset());
+			gfc_vector2d_scale_by(draw_pos, draw_pos, scale);
+			gfc_vector2d_add(draw_pos, draw_pos, screen_res);
+			gf2d_debug_draw_rect(gfc_rect(draw_pos.x, draw_pos.y, scale.x * rect.w, scale.y * rect.h), GFC_COLOR_LIGHTGREEN);
+		}
+	}
+}
+
+/**
+ * @brief add a tile overlap to a collision list
+ */
+static void space_collect_tile_collision(const TileOverlap *overlap, void *data) {
+	Collision *coll = collision_new();
+	if (!coll) return;
+	coll->poc = overlap->poc;
+	coll->normal = overlap->normal;
+	gfc_list_append((GFC_List *)data, coll);
 }
 
 /**
@@ -116,6 +197,10 @@ GFC_List *space_overlap_entity_static_shape(Space *self, Entity *entity) {
 	GFC_Vector2D poc;
 	GFC_Vector2D normal;
 
+	// A sleeping body is at rest, so its contacts cannot have changed
+	if (entity->body && entity->body->sleeping) return NULL;
+	if (entity->body && !(entity->body->mask & self->static_layer)) return NULL;
+
 	// Create the collision list
 	GFC_List *collision_list = gfc_list_new();
 
@@ -125,6 +210,9 @@ GFC_List *space_overlap_entity_static_shape(Space *self, Entity *entity) {
 	// Entity world space collider
 	GFC_Circle world_space_collider = gfc_circle(entity->collider.x + entity->position.x, entity->collider.y + entity->position.y, entity->collider.r);
 
+	// Tiles are tested in batches straight from the grid
+	space_overlap_circle_tiles(self, world_space_collider, space_collect_tile_collision, collision_list);
+
 	// For each static body do the overlap test
 	for (i = 0; i < c; ++i) {
 		curr = gfc_list_get_nth(self->static_shapes, i);
@@ -145,48 +233,357 @@ GFC_List *space_overlap_entity_static_shape(Space *self, Entity *entity) {
 	}
 }
 
+void space_set_tile_grid(Space *self, Uint32 *tile_map, TileData *tile_data, Uint32 tile_count, Uint32 width, Uint32 height, float tile_size) {
+	if (!self) return;
+	self->tile_map = tile_map;
+	self->tile_data = tile_data;
+	self->tile_count = tile_count;
+	self->grid_width = width;
+	self->grid_height = height;
+	self->tile_size = tile_size;
+}
+
+TileData *space_get_solid_tile(Space *self, Sint32 x, Sint32 y) {
+	Uint32 tile;
+	TileData *data;
+	if (!self || !self->tile_map || !self->tile_data) return NULL;
+	if (x < 0 || y < 0 || x >= (Sint32)self->grid_width || y >= (Sint32)self->grid_height) return NULL;
+
+	tile = self->tile_map[y * self->grid_width + x];
+	if (!tile || tile > self->tile_count) return NULL;
+
+	data = &self->tile_data[tile - 1];
+	if (data->collision_type == TCT_NONE) return NULL;
+	return data;
+}
+
+/**
+ * @brief wake a body found near a changed tile
+ */
+static void space_wake_body(Body *body, void *data) {
+	if (body && body->sleeping) body_wake(body);
+}
+
+void space_tile_changed(Space *self, Sint32 x, Sint32 y) {
+	GFC_Rect area;
+	if (!self || !self->tile_map) return;
+
+	// Grow the cell by a tile on every side so bodies resting against it are included
+	area = gfc_rect((x - 1) * self->tile_size, (y - 1) * self->tile_size, self->tile_size * 3, self->tile_size * 3);
+	broadphase_query(&self->broadphase, area, space_wake_body, NULL);
+}
+
+GFC_Rect space_get_tile_rect(Space *self, TileData *tile, Sint32 x, Sint32 y) {
+	if (!self || !tile) return gfc_rect(0, 0, 0, 0);
+	return gfc_rect(x * self->tile_size, y * self->tile_size, tile->collision_box.x, tile->collision_box.y);
+}
+
+/**
+ * @brief run the circle kernel on a batch of tiles and report the overlaps
+ * @return the number of overlaps reported
+ */
+static Uint32 space_flush_tile_batch(Space *self, GFC_Circle circle, CollisionRectBatch *batch, Sint32 *cells, void (*callback)(const TileOverlap *overlap, void *data), void *data) {
+	CollisionRectHits hits;
+	TileOverlap overlap;
+	Uint32 i, mask, count = 0;
+
+	// The kernel reads whole groups of four, give the unused lanes of the last group empty rects
+	for (i = batch->count; i % 4; ++i) {
+		batch->x[i] = batch->y[i] = batch->w[i] = batch->h[i] = 0;
+	}
+	mask = collision_circle_rect_batch(circle, batch, &hits);
+	for (i = 0; mask; ++i, mask >>= 1) {
+		if (!(mask & 1)) continue;
+		overlap.x = cells[i] % (Sint32)self->grid_width;
+		overlap.y = cells[i] / (Sint32)self->grid_width;
+		overlap.tile = space_get_solid_tile(self, overlap.x, overlap.y);
+		overlap.poc = gfc_vector2d(hits.poc_x[i], hits.poc_y[i]);
+		overlap.normal = gfc_vector2d(hits.normal_x[i], hits.normal_y[i]);
+		overlap.depth = hits.depth[i];
+
+		// One way tiles only hold up things resting on their top
+		if (overlap.tile->collision_type == TCT_ONE_WAY && (overlap.normal.y >= 0 || circle.y > batch->y[i])) continue;
+
+		if (callback) callback(&overlap, data);
+		count++;
+	}
+	batch->count = 0;
+	return count;
+}
+
+Uint32 space_overlap_circle_tiles(Space *self, GFC_Circle circle, void (*callback)(const TileOverlap *overlap, void *data), void *data) {
+	CollisionRectBatch batch;
+	Sint32 cells[COLLISION_RECT_BATCH];
+	Sint32 x, y, x0, y0, x1, y1;
+	TileData *tile;
+	GFC_Rect rect;
+	Uint32 count = 0;
+	if (!self || !self->tile_map || self->tile_size <= 0) return 0;
+
+	// Only the cells under the circle's bounds can hold an overlapping tile
+	x0 = MAX((Sint32)floor((circle.x - circle.r) / self->tile_size), 0);
+	y0 = MAX((Sint32)floor((circle.y - circle.r) / self->tile_size), 0);
+	x1 = MIN((Sint32)floor((circle.x + circle.r) / self->tile_size), (Sint32)self->grid_width - 1);
+	y1 = MIN((Sint32)floor((circle.y + circle.r) / self->tile_size), (Sint32)self->grid_height - 1);
+
+	batch.count = 0;
+	for (y = y0; y <= y1; ++y) {
+		for (x = x0; x <= x1; ++x) {
+			tile = space_get_solid_tile(self, x, y);
+			if (!tile) continue;
+			rect = space_get_tile_rect(self, tile, x, y);
+			batch.x[batch.count] = rect.x;
+			batch.y[batch.count] = rect.y;
+			batch.w[batch.count] = rect.w;
+			batch.h[batch.count] = rect.h;
+			cells[batch.count] = y * self->grid_width + x;
+			if (++batch.count == COLLISION_RECT_BATCH) {
+				count += space_flush_tile_batch(self, circle, &batch, cells, callback, data);
+			}
+		}
+	}
+	if (batch.count) count += space_flush_tile_batch(self, circle, &batch, cells, callback, data);
+	return count;
+}
+
 void space_add_entity(Space *self, Entity *ent) {
 	slog("entering the function");
 	if (!ent || !ent->body || !self || !self->bodies) return;
 	slog("succ2?");
 	// Append the entity's body to the space
+	ent->body->id = ++self->next_body_id;
+	ent->body->space = self;
 	gfc_list_append(self->bodies, ent->body);
+	self->triggers_dirty = 1;
+}
+
+void space_remove_body(Space *self, Body *body) {
+	Uint32 i, c;
+	Joint *joint;
+	if (!self || !body || body->space != self) return;
+	gfc_list_delete_data(self->bodies, body);
+	body->space = NULL;
+
+	// Queries between updates read the proxies, so they must not keep pointing at the body
+	broadphase_remove_body(&self->broadphase, body);
+
+	// Joints cannot outlive either of their bodies
+	c = gfc_list_count(self->joints);
+	for (i = c; i > 0; --i) {
+		joint = gfc_list_get_nth(self->joints, i - 1);
+		if (!joint || (joint->a != body && joint->b != body)) continue;
+		space_remove_joint(self, joint);
+	}
+
+	// Let any trigger the body was inside know that it left
+	c = gfc_list_count(self->triggers);
+	for (i = 0; i < c; ++i) {
+		trigger_remove_body(gfc_list_get_nth(self->triggers, i), body);
+	}
+}
+
+void space_add_trigger(Space *self, Trigger *trigger) {
+	if (!self || !trigger) return;
+	gfc_list_append(self->triggers, trigger);
+	self->triggers_dirty = 1;
+}
+
+void space_remove_trigger(Space *self, Trigger *trigger) {
+	if (!self || !trigger) return;
+	gfc_list_delete_data(self->triggers, trigger);
+	trigger_free(trigger);
+}
+
+void space_add_joint(Space *self, Joint *joint) {
+	if (!self || !joint) return;
+	gfc_list_append(self->joints, joint);
+	self->joint_batches.dirty = 1;
+	body_wake(joint->a);
+	if (joint->b) body_wake(joint->b);
+}
+
+void space_remove_joint(Space *self, Joint *joint) {
+	if (!self || !joint) return;
+	gfc_list_delete_data(self->joints, joint);
+	self->joint_batches.dirty = 1;
+	joint_free(joint);
 }
 
 /**
- * @brief take a simulation step
+ * @brief check if a body moved on its last step, rather than just being awake
+ * @note rest_steps is reset whenever a body's speed or acceleration is over the sleep threshold,
+ *       and when the body is woken, so a body counting towards sleep is at rest
+ */
+static Uint8 space_body_moving(Body *body) {
+	return !body->sleeping && body->rest_steps == 0;
+}
+
+void space_collide(Space *self) {
+	Uint32 i;
+	Contact *contact;
+	GFC_Rect grid;
+	if (!self) return;
+
+	if (self->tile_map) {
+		grid = gfc_rect(0, 0, self->grid_width * self->tile_size, self->grid_height * self->tile_size);
+	}
+	broadphase_update(&self->broadphase, self->bodies, self->static_shapes, self->static_layer, self->tile_map ? &grid : NULL);
+	narrowphase_run(self, self->broadphase.pairs, self->broadphase.pair_count, &self->contacts);
+
+	// Wake sleepers that something is pushing into, resting neighbours leave each other asleep
+	for (i = 0; i < self->contacts.count; ++i) {
+		contact = &self->contacts.contacts[i];
+		if (!contact->b) continue;
+		if (contact->a->sleeping && space_body_moving(contact->b)) body_wake(contact->a);
+		else if (contact->b->sleeping && space_body_moving(contact->a)) body_wake(contact->b);
+	}
+}
+
+/**
+ * @brief get the distance a body can safely move in one step
+ */
+static float space_body_step_size(Space *self, Body *body) {
+	GFC_Rect bounds;
+	float size;
+	if (body->collider.type == ST_CIRCLE) {
+		size = body->collider.s.c.r;
+	} else {
+		bounds = collision_shape_bounds(body->collider);
+		size = MIN(bounds.w, bounds.h) * 0.5;
+	}
+	if (self->tile_map && self->tile_size > 0) size = MIN(size, self->tile_size);
+	return size * SPACE_SUBSTEP_TRAVEL;
+}
+
+Uint32 space_plan_substeps(Space *self, float delta_time) {
+	Uint32 i, c, substeps, step_count = 1, max_substeps;
+	Body *curr;
+	Joint *joint;
+	float travel, size;
+	if (!self) return 0;
+	max_substeps = MAX(self->max_substeps, 1);
+
+	c = gfc_list_count(self->bodies);
+	for (i = 0; i < c; ++i) {
+		curr = gfc_list_get_nth(self->bodies, i);
+		if (!curr) continue;
+		curr->substeps = 1;
+		if (curr->sleeping) continue;
+
+		// Estimate the distance covered this update, including what the acceleration adds
+		travel = (gfc_vector2d_magnitude(curr->velocity) + gfc_vector2d_magnitude(curr->acceleration) * delta_time) * delta_time;
+		size = space_body_step_size(self, curr);
+		if (size > 0) {
+			substeps = (Uint32)ceilf(travel / size);
+		} else {
+			substeps = max_substeps; // No collider to measure against, play it safe
+		}
+		curr->substeps = MIN(MAX(substeps, 1), max_substeps);
+		step_count = MAX(step_count, curr->substeps);
+	}
+
+	// Jointed bodies share one step size so the joints see consistent velocities
+	c = gfc_list_count(self->joints);
+	for (i = 0; i < c; ++i) {
+		joint = gfc_list_get_nth(self->joints, i);
+		if (!joint) continue;
+		joint->a->substeps = step_count;
+		if (joint->b) joint->b->substeps = step_count;
+	}
+	return step_count;
+}
+
+/**
+ * @brief check if a body takes one of its own steps during a substep of the update
+ * @param body the body being checked
+ * @param step the index of the substep
+ * @param step_count how many substeps the update is split into
+ * @return 1 if the body moves this substep, spreading its steps evenly across the update
+ */
+static Uint8 space_body_steps(Body *body, Uint32 step, Uint32 step_count) {
+	return (step + 1) * body->substeps / step_count != step * body->substeps / step_count;
+}
+
+/**
+ * @brief run one substep of an update, moving the bodies whose turn it is, then colliding everything
  * @param self the space object to be stepped
- * @param delta_time the time that passes in a single step
+ * @param step the index of the substep
+ * @param step_count how many substeps the update is split into
+ * @param delta_time the time that passes over the whole update
  */
-void space_step(Space *self, float delta_time) {
+static void space_substep(Space *self, Uint32 step, Uint32 step_count, float delta_time) {
 	int i, c;
 	Body *curr;
 	GFC_Vector2D dx, dv;
-	slog("step");
+	float body_time;
+	float rest_sq = self->sleep_velocity * self->sleep_velocity;
 
 	c = gfc_list_count(self->bodies);
 	for (i = 0; i < c; ++i) {
-		// Get and verify ptr
+		// Get and verify ptr, sleeping bodies are skipped entirely
 		curr = gfc_list_get_nth(self->bodies, i);
-		if (!curr) continue;
+		if (!curr || curr->sleeping || !curr->substeps) continue;
+		if (!space_body_steps(curr, step, step_count)) continue;
+		body_time = delta_time / curr->substeps;
 
 		// Integrate forces (for now just add net_acceleration to acceleration)
 		curr->net_acceleration = gfc_vector2d(0, 0); // Reset net acceleration
 		gfc_vector2d_copy(curr->net_acceleration, curr->acceleration); // Copy applied acceleration into net acceleration
-									       // Apply other forces (joints, e.t.c.)
 
 		// Semi implicit euler method
 		// Integrate velocity
 		gfc_vector2d_copy(dv, curr->net_acceleration);
-		gfc_vector2d_scale_by(dv, dv, gfc_vector2d(delta_time, delta_time));
+		gfc_vector2d_scale_by(dv, dv, gfc_vector2d(body_time, body_time));
 		gfc_vector2d_add(curr->velocity, curr->velocity, dv);
-		slog("%f, %f", curr->velocity.x, curr->velocity.y);
-		
+	}
+
+	// Joints correct the new velocities before they are used to move the bodies
+	if (self->joint_batches.dirty) solver_color_joints(&self->joint_batches, self->joints);
+	solver_solve_joints(&self->joint_batches, self->joint_iterations, delta_time / step_count);
+
+	for (i = 0; i < c; ++i) {
+		curr = gfc_list_get_nth(self->bodies, i);
+		if (!curr || curr->sleeping || !curr->substeps) continue;
+		if (!space_body_steps(curr, step, step_count)) continue;
+		body_time = delta_time / curr->substeps;
+		self->triggers_dirty = 1;
+
 		// Then integrate position
 		gfc_vector2d_copy(dx, curr->velocity);
-		gfc_vector2d_scale_by(dx, dx, gfc_vector2d(delta_time, delta_time));
-		gfc_vector2d_add(curr->position, curr->position, dx);
+		gfc_vector2d_scale_by(dx, dx, gfc_vector2d(body_time, body_time));
+		if (curr->controller) {
+			character_move(curr->controller, self, curr, dx);
+		} else {
+			gfc_vector2d_add(curr->position, curr->position, dx);
+		}
+
+		// Count resting steps and put the body to sleep once it has been at rest long enough
+		if (gfc_vector2d_magnitude_squared(curr->velocity) < rest_sq
+				&& gfc_vector2d_magnitude_squared(curr->net_acceleration) < rest_sq) {
+			curr->rest_steps++;
+			if (curr->rest_steps >= self->sleep_steps) body_sleep(curr);
+		} else {
+			curr->rest_steps = 0;
+		}
+	}
+
+	// Find the contacts for the new positions and resolve them
+	space_collide(self);
+	solver_solve_contacts(&self->contacts, &self->contact_cache, self->solver_iterations);
+}
+
+void space_step(Space *self, float delta_time) {
+	Uint32 i, c;
+	Body *curr;
+	if (!self) return;
+
+	// Every body takes exactly one step
+	c = gfc_list_count(self->bodies);
+	for (i = 0; i < c; ++i) {
+		curr = gfc_list_get_nth(self->bodies, i);
+		if (curr) curr->substeps = 1;
 	}
+	space_substep(self, 0, 1, delta_time);
 }
 
 /**
@@ -194,11 +591,33 @@ void space_step(Space *self, float delta_time) {
  * @param self the space object to be updated
  */
 void space_update(Space *self) {
+	Uint32 i, c, step_count;
 	if (!self) return;
 
-	for (int i = 0; i < 10; i++) {
-		space_step(self, 0.1);
+	step_count = space_plan_substeps(self, SPACE_UPDATE_TIME);
+	for (i = 0; i < step_count; i++) {
+		space_substep(self, i, step_count, SPACE_UPDATE_TIME);
+	}
+
+	// Forget pairs that are no longer touching
+	contact_cache_prune(&self->contact_cache);
+
+	// Triggers only see where the bodies ended up
+	c = gfc_list_count(self->triggers);
+	if (!c) return;
+
+	// Nothing moved, so every overlap set is still current
+	if (!self->triggers_dirty) {
+		for (i = 0; i < c; ++i) {
+			trigger_stay(gfc_list_get_nth(self->triggers, i));
+		}
+		return;
+	}
+	broadphase_refresh(&self->broadphase, self->bodies);
+	for (i = 0; i < c; ++i) {
+		trigger_update(gfc_list_get_nth(self->triggers, i), &self->broadphase);
 	}
+	self->triggers_dirty = 0;
 }
 
 
@@ -0,0 +1,122 @@
+#include "simple_logger.h"
+
+#include "trigger.h"
+#include "collision.h"
+
+Trigger *trigger_new(GFC_Shape shape, Uint32 mask) {
+	Trigger *trigger;
+	trigger = gfc_allocate_array(sizeof(Trigger), 1);
+	if (!trigger) {
+		slog("failed to allocate memory for trigger");
+		return NULL;
+	}
+	trigger->shape = shape;
+	trigger->mask = mask;
+	return trigger;
+}
+
+void trigger_free(Trigger *self) {
+	if (!self) return;
+	if (self->overlaps) free(self->overlaps);
+	if (self->scratch) free(self->scratch);
+	free(self);
+}
+
+/**
+ * @brief make sure both overlap buffers can hold at least the given number of bodies
+ * @return 0 on success, -1 if memory could not be allocated
+ */
+static int trigger_reserve(Trigger *self, Uint32 count) {
+	Body **overlaps, **scratch;
+	Uint32 capacity;
+	if (count <= self->capacity) return 0;
+
+	capacity = self->capacity ? self->capacity * 2 : 8;
+	while (capacity < count) capacity *= 2;
+	overlaps = realloc(self->overlaps, sizeof(Body*) * capacity);
+	if (!overlaps) {
+		slog("failed to grow trigger overlap set to %i bodies", capacity);
+		return -1;
+	}
+	self->overlaps = overlaps;
+	scratch = realloc(self->scratch, sizeof(Body*) * capacity);
+	if (!scratch) {
+		slog("failed to grow trigger overlap set to %i bodies", capacity);
+		return -1;
+	}
+	self->scratch = scratch;
+	self->capacity = capacity;
+	return 0;
+}
+
+/**
+ * @brief broadphase callback that adds a candidate body to the scratch set if it really overlaps
+ */
+static void trigger_collect(Body *body, void *data) {
+	Trigger *self = data;
+	GFC_Vector2D poc, normal;
+	Uint32 i;
+
+	if (!(self->mask & body->layer)) return;
+	if (!gfc_shape_overlap_poc(self->shape, body_world_collider(body), &poc, &normal)) return;
+	if (trigger_reserve(self, self->scratch_count + 1) != 0) return;
+
+	// Insert by id to keep the set sorted, candidates arrive nearly sorted so this is short
+	for (i = self->scratch_count; i > 0 && self->scratch[i - 1]->id > body->id; --i) {
+		self->scratch[i] = self->scratch[i - 1];
+	}
+	self->scratch[i] = body;
+	self->scratch_count++;
+}
+
+void trigger_update(Trigger *self, Broadphase *broadphase) {
+	Uint32 i = 0, j = 0;
+	Body **swap;
+	if (!self || !broadphase) return;
+
+	// Build the new overlap set
+	self->scratch_count = 0;
+	broadphase_query(broadphase, collision_shape_bounds(self->shape), trigger_collect, self);
+
+	// Walk both sorted sets together, only bodies in one of them changed membership
+	while (i < self->overlap_count || j < self->scratch_count) {
+		if (j >= self->scratch_count || (i < self->overlap_count && self->overlaps[i]->id < self->scratch[j]->id)) {
+			if (self->on_exit) self->on_exit(self, self->overlaps[i]);
+			i++;
+		} else if (i >= self->overlap_count || self->scratch[j]->id < self->overlaps[i]->id) {
+			if (self->on_enter) self->on_enter(self, self->scratch[j]);
+			j++;
+		} else {
+			if (self->on_stay) self->on_stay(self, self->scratch[j]);
+			i++;
+			j++;
+		}
+	}
+
+	// The new set becomes the current one
+	swap = self->overlaps;
+	self->overlaps = self->scratch;
+	self->scratch = swap;
+	self->overlap_count = self->scratch_count;
+	self->scratch_count = 0;
+}
+
+void trigger_stay(Trigger *self) {
+	Uint32 i;
+	if (!self || !self->on_stay) return;
+	for (i = 0; i < self->overlap_count; ++i) {
+		self->on_stay(self, self->overlaps[i]);
+	}
+}
+
+void trigger_remove_body(Trigger *self, Body *body) {
+	Uint32 i;
+	if (!self || !body) return;
+	for (i = 0; i < self->overlap_count; ++i) {
+		if (self->overlaps[i] != body) continue;
+		memmove(&self->overlaps[i], &self->overlaps[i + 1], sizeof(Body*) * (self->overlap_count - i - 1));
+		self->overlap_count--;
+		if (self->on_exit) self->on_exit(self, body);
+		return;
+	}
+}
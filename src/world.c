@@ -6,6 +6,7 @@
 #include "gfc_config.h"
 
 #include "gf2d_graphics.h"
+#include "gf2d_render_queue.h"
 
 #include "world.h"
 #include "space.h"
@@ -50,15 +51,20 @@ void world_free(World *world) {
 	// Verify that world pointer exists
 	if (!world) return;
 
-	// Free the background
-	if (world->background) gf2d_sprite_free(world->background);
-	if (world->foreground) gf2d_sprite_free(world->foreground);
+	// Free the parallax layers
+	Uint32 layer;
+	for (layer = 0; layer < world->parallax_count; layer++) {
+		if (world->parallax[layer].sprite) gf2d_sprite_free(world->parallax[layer].sprite);
+	}
 	slog("freed images");
 	
 	// Free the tileset, tile data, and tile map
 	if (world->tile_set) gf2d_sprite_free(world->tile_set);
 	if (world->tile_data) free(world->tile_data);
 	if (world->tile_map) free(world->tile_map);
+	if (world->animated_tiles) free(world->animated_tiles);
+	world_free_tile_chunks(world);
+	if (world->chunks) free(world->chunks);
 	slog("freed tilestuff");
 
 	// Free the entity list
@@ -102,72 +108,466 @@ World *world_new(Uint32 width, Uint32 height, Uint32 tile_count) {
 	return world;
 }
 
+/**
+ * @brief check if a tile id cycles through an animation
+ */
+static Uint8 world_tile_is_animated(World *world, Uint32 id) {
+	if (!id || id > world->tile_count) return 0;
+	return world->tile_data[id - 1].anim_frame_count > 0;
+}
+
+/**
+ * @brief get the tile set frame a tile shows
+ * @param world the world the tile belongs to
+ * @param id the tile's id, not 0
+ * @param now the current time in milliseconds
+ * @return the frame to draw
+ */
+static Uint32 world_get_tile_frame(World *world, Uint32 id, Uint32 now) {
+	TileData *data;
+	if (!world_tile_is_animated(world, id)) return id - 1;
+	data = &world->tile_data[id - 1];
+	return data->anim_frames[(now / MAX(data->anim_frame_duration, 1)) % data->anim_frame_count];
+}
+
+/**
+ * @brief find where a tile map index is, or would go, in the sorted list of animated tiles
+ * @return the position of the first animated tile at or after index
+ */
+static Uint32 world_find_animated_tile(World *world, Uint32 index) {
+	Uint32 low = 0, high = world->animated_count, mid;
+	while (low < high) {
+		mid = (low + high) / 2;
+		if (world->animated_tiles[mid] < index) low = mid + 1;
+		else high = mid;
+	}
+	return low;
+}
+
+/**
+ * @brief add a tile map index to the animated tile list, keeping it sorted
+ */
+static void world_add_animated_tile(World *world, Uint32 index) {
+	Uint32 i, *tiles;
+	if (world->animated_count >= world->animated_capacity) {
+		tiles = realloc(world->animated_tiles, sizeof(Uint32) * MAX(world->animated_capacity * 2, 16));
+		if (!tiles) {
+			slog("failed to grow the animated tile list");
+			return;
+		}
+		world->animated_tiles = tiles;
+		world->animated_capacity = MAX(world->animated_capacity * 2, 16);
+	}
+	i = world_find_animated_tile(world, index);
+	memmove(&world->animated_tiles[i + 1], &world->animated_tiles[i], sizeof(Uint32) * (world->animated_count - i));
+	world->animated_tiles[i] = index;
+	world->animated_count++;
+}
+
+/**
+ * @brief remove a tile map index from the animated tile list
+ */
+static void world_remove_animated_tile(World *world, Uint32 index) {
+	Uint32 i = world_find_animated_tile(world, index);
+	if (i >= world->animated_count || world->animated_tiles[i] != index) return;
+	memmove(&world->animated_tiles[i], &world->animated_tiles[i + 1], sizeof(Uint32) * (world->animated_count - i - 1));
+	world->animated_count--;
+}
+
+/**
+ * @brief pick the chunk size for a world, the largest whole number of tiles that fits in WORLD_CHUNK_SIZE,
+ *        and collect the animated tiles that are drawn over the chunks instead of baked into them
+ * @param world the world whose tile layer is being set up
+ */
 void world_build_tile_layer(World *world) {
+	Uint32 i, count;
+	if (!world || !world->tile_size) return;
+	world->chunk_size = MAX(WORLD_CHUNK_SIZE / world->tile_size, 1) * world->tile_size;
+
+	// Scanning in map order keeps the list sorted
+	count = (Uint32)world->world_size.x * (Uint32)world->world_size.y;
+	for (i = 0; i < count; i++) {
+		if (world_tile_is_animated(world, world->tile_map[i])) world_add_animated_tile(world, i);
+	}
+}
+
+void world_free_tile_chunks(World *world) {
+	Uint32 i;
 	if (!world) return;
+	for (i = 0; i < world->chunk_count; i++) {
+		gf2d_sprite_delete(world->chunks[i].sprite);
+	}
+	world->chunk_count = 0;
+}
 
-	// Initialize variables
+/**
+ * @brief draw a range of tiles onto a surface, air and animated tiles are left blank
+ * @param world the world whose tiles are drawn
+ * @param x0, y0 the first column and row, drawn at the surface's top left corner
+ * @param x1, y1 one past the last column and row
+ * @param surface the surface to draw onto
+ */
+static void world_draw_tiles_to_surface(World *world, Sint32 x0, Sint32 y0, Sint32 x1, Sint32 y1, SDL_Surface *surface) {
 	GFC_Vector2D position = {0};
-	Uint32 frame;
-	int i, j, index;
+	Sint32 x, y;
+	Uint32 id;
+	for (y = y0; y < y1; y++) {
+		for (x = x0; x < x1; x++) {
+			id = world->tile_map[y * (Sint32)world->world_size.x + x];
+			if (!id || world_tile_is_animated(world, id)) continue;
+			position.x = (x - x0) * world->tile_size;
+			position.y = (y - y0) * world->tile_size;
+			gf2d_sprite_draw_to_surface(world->tile_set, position, NULL, NULL, id - 1, surface);
+		}
+	}
+}
+
+/**
+ * @brief bake the tiles of one chunk into a texture
+ * @param world the world being drawn
+ * @param cx the chunk's column
+ * @param cy the chunk's row
+ * @return NULL on error, otherwise a sprite holding the chunk's tiles
+ */
+static Sprite *world_bake_tile_chunk(World *world, Sint32 cx, Sint32 cy) {
+	Uint32 chunk_tiles;
+	Sint32 x0, y0, x1, y1;
+	Sprite *chunk;
+	SDL_Surface *surface;
+
+	// The chunk's range of tiles, chunks on the far edges are cut down to the world
+	chunk_tiles = world->chunk_size / world->tile_size;
+	x0 = cx * chunk_tiles;
+	y0 = cy * chunk_tiles;
+	x1 = MIN(x0 + (Sint32)chunk_tiles, (Sint32)world->world_size.x);
+	y1 = MIN(y0 + (Sint32)chunk_tiles, (Sint32)world->world_size.y);
+
+	chunk = gf2d_sprite_new();
+	if (!chunk) {
+		slog("failed to allocate a sprite for tile chunk (%i, %i)", cx, cy);
+		return NULL;
+	}
+	surface = gf2d_graphics_create_surface((x1 - x0) * world->tile_size, (y1 - y0) * world->tile_size);
+	if (!surface) {
+		slog("failed to create surface for tile chunk (%i, %i)", cx, cy);
+		gf2d_sprite_delete(chunk);
+		return NULL;
+	}
+
+	world_draw_tiles_to_surface(world, x0, y0, x1, y1, surface);
+
+	chunk->texture = SDL_CreateTextureFromSurface(gf2d_graphics_get_renderer(), surface);
+	if (!chunk->texture) {
+		slog("failed to create texture for tile chunk (%i, %i)", cx, cy);
+		SDL_FreeSurface(surface);
+		gf2d_sprite_delete(chunk);
+		return NULL;
+	}
+	chunk->frame_w = surface->w;
+	chunk->frame_h = surface->h;
+	chunk->frames_per_line = 1;
+	gf2d_sprite_build_mips(chunk, surface);
+	SDL_FreeSurface(surface);
+	return chunk;
+}
 
-	// Create the blank surface
-	world->tile_layer = gf2d_sprite_new();
-	if (!world->tile_layer) {
-		slog("failed to allocate memory for tile layer");
+/**
+ * @brief redraw a chunk's edited tiles and upload only that part of its texture
+ * @param world the world being drawn
+ * @param chunk the chunk with a dirty rect
+ */
+static void world_redraw_tile_chunk(World *world, TileChunk *chunk) {
+	Uint32 chunk_tiles, format;
+	SDL_Surface *surface, *converted;
+	SDL_Rect region;
+	Sint32 x0, y0;
+
+	chunk_tiles = world->chunk_size / world->tile_size;
+	x0 = chunk->x * chunk_tiles + chunk->dirty.x;
+	y0 = chunk->y * chunk_tiles + chunk->dirty.y;
+	gfc_rect_set(
+		region,
+		chunk->dirty.x * world->tile_size,
+		chunk->dirty.y * world->tile_size,
+		chunk->dirty.w * world->tile_size,
+		chunk->dirty.h * world->tile_size);
+	chunk->dirty.w = chunk->dirty.h = 0;
+
+	surface = gf2d_graphics_create_surface(region.w, region.h);
+	if (!surface) {
+		slog("failed to create surface to redraw tile chunk (%i, %i)", chunk->x, chunk->y);
 		return;
 	}
-	/*
-	world->tile_layer->surface = SDL_CreateRGBSurface(
-		0, // Flags not used???
-		world->world_size.x * world->tile_size,
-		world->world_size.y * world->tile_size,
-		32,
-		0, // No R mask
-		0, // No G mask
-		0, // No B mask
-		0  // No A mask
-	);*/
-	world->tile_layer->surface = gf2d_graphics_create_surface(world->world_size.x * world->tile_size, world->world_size.y * world->tile_size);
-	slog("printing the world size %f %f %i", world->world_size.x, world->world_size.y, world->tile_size);
-	if (!world->tile_layer->surface) {
-		slog("failed to create surface");
+	world_draw_tiles_to_surface(world, x0, y0, x0 + region.w / world->tile_size, y0 + region.h / world->tile_size, surface);
+
+	// The texture's format is the renderer's choice, so match it before uploading
+	SDL_QueryTexture(chunk->sprite->texture, &format, NULL, NULL, NULL);
+	converted = SDL_ConvertSurfaceFormat(surface, format, 0);
+	gf2d_sprite_update_mips(chunk->sprite, surface, region);
+	SDL_FreeSurface(surface);
+	if (!converted) {
+		slog("failed to convert redrawn tiles for chunk (%i, %i): %s", chunk->x, chunk->y, SDL_GetError());
 		return;
 	}
-	
-	// Iterate over tilemap and draw tiles
-	for (i = 0; i < world->world_size.y; i++) {
-		for (j = 0; j < world->world_size.x; j++) {
-			index = i * world->world_size.x + j;
-
-			position.x = j * world->tile_size;
-			position.y = i * world->tile_size;
-			frame = world->tile_map[index] - 1;
-			if (frame < 0) continue;
-
-			gf2d_sprite_draw_to_surface(
-				world->tile_set,
-				position,
-				NULL,
-				NULL,
-				frame,
-				world->tile_layer->surface
-			);
-		}
+	if (SDL_UpdateTexture(chunk->sprite->texture, &region, converted->pixels, converted->pitch) != 0) {
+		slog("failed to upload redrawn tiles for chunk (%i, %i): %s", chunk->x, chunk->y, SDL_GetError());
 	}
+	SDL_FreeSurface(converted);
+}
 
-	// Render the texture
-	world->tile_layer->texture = SDL_CreateTextureFromSurface(
-		gf2d_graphics_get_renderer(),
-		world->tile_layer->surface
-	);
-	if (!world->tile_layer->texture) {
-		slog("failed to convert texture to surface");
+/**
+ * @brief grow a baked chunk's dirty rect to cover an edited tile
+ * @param world the world that was edited
+ * @param x the column of the edited tile
+ * @param y the row of the edited tile
+ * @note chunks that are not baked have nothing to update, they read the new tile when they are baked
+ */
+static void world_mark_tile_dirty(World *world, Uint32 x, Uint32 y) {
+	Uint32 i, chunk_tiles;
+	Sint32 cx, cy, left, top, right, bottom;
+	SDL_Rect *dirty;
+
+	if (world->render_mode != TRM_BAKED || !world->chunk_size) return;
+	chunk_tiles = world->chunk_size / world->tile_size;
+	cx = x / chunk_tiles;
+	cy = y / chunk_tiles;
+	for (i = 0; i < world->chunk_count; i++) {
+		if (world->chunks[i].x != cx || world->chunks[i].y != cy) continue;
+		dirty = &world->chunks[i].dirty;
+		left = x - cx * chunk_tiles;
+		top = y - cy * chunk_tiles;
+		right = left + 1;
+		bottom = top + 1;
+		if (dirty->w) {
+			right = MAX(right, dirty->x + dirty->w);
+			bottom = MAX(bottom, dirty->y + dirty->h);
+			left = MIN(left, dirty->x);
+			top = MIN(top, dirty->y);
+		}
+		gfc_rect_set((*dirty), left, top, right - left, bottom - top);
 		return;
 	}
+}
+
+/**
+ * @brief find a chunk in the cache, baking it if it is not there
+ * @param world the world being drawn
+ * @param cx the chunk's column
+ * @param cy the chunk's row
+ * @return NULL on error, otherwise the chunk's sprite
+ */
+static Sprite *world_get_tile_chunk(World *world, Sint32 cx, Sint32 cy) {
+	Uint32 i, oldest = 0;
+	TileChunk *chunk = NULL, *chunks;
+
+	for (i = 0; i < world->chunk_count; i++) {
+		if (world->chunks[i].x != cx || world->chunks[i].y != cy) continue;
+		world->chunks[i].last_used = world->chunk_frame;
+		if (world->chunks[i].dirty.w) world_redraw_tile_chunk(world, &world->chunks[i]);
+		return world->chunks[i].sprite;
+	}
+
+	if (world->chunk_count >= WORLD_CHUNK_CACHE) {
+		// Replace the least recently drawn chunk, unless every chunk is already on screen
+		for (i = 1; i < world->chunk_count; i++) {
+			if (world->chunks[i].last_used < world->chunks[oldest].last_used) oldest = i;
+		}
+		if (world->chunks[oldest].last_used != world->chunk_frame) {
+			chunk = &world->chunks[oldest];
+			gf2d_sprite_delete(chunk->sprite);
+			chunk->sprite = NULL;
+		}
+	}
+	if (!chunk) {
+		if (world->chunk_count >= world->chunk_capacity) {
+			chunks = realloc(world->chunks, sizeof(TileChunk) * (world->chunk_capacity + WORLD_CHUNK_CACHE));
+			if (!chunks) {
+				slog("failed to grow the tile chunk cache");
+				return NULL;
+			}
+			world->chunks = chunks;
+			world->chunk_capacity += WORLD_CHUNK_CACHE;
+		}
+		chunk = &world->chunks[world->chunk_count++];
+	}
+
+	chunk->x = cx;
+	chunk->y = cy;
+	gfc_rect_set(chunk->dirty, 0, 0, 0, 0);
+	chunk->last_used = world->chunk_frame;
+	chunk->sprite = world_bake_tile_chunk(world, cx, cy);
+	if (!chunk->sprite) {
+		// Give the slot back so the chunk is tried again next frame
+		*chunk = world->chunks[--world->chunk_count];
+		return NULL;
+	}
+	return chunk->sprite;
+}
+
+/**
+ * @brief free chunks that were not drawn this frame until the cache is back within WORLD_CHUNK_CACHE
+ * @param world the world that was drawn
+ */
+static void world_trim_tile_chunks(World *world) {
+	Uint32 i;
+	for (i = 0; i < world->chunk_count && world->chunk_count > WORLD_CHUNK_CACHE;) {
+		if (world->chunks[i].last_used == world->chunk_frame) {
+			i++;
+			continue;
+		}
+		gf2d_sprite_delete(world->chunks[i].sprite);
+		world->chunks[i] = world->chunks[--world->chunk_count];
+	}
+}
+
+/**
+ * @brief get the range of tiles, chunks or any other grid of square cells under the camera's view
+ * @param cell_size the width and height of a cell in pixels
+ * @param columns the number of columns in the grid
+ * @param rows the number of rows in the grid
+ * @param x0, y0, x1, y1 set to the first and last visible column and row, the range is empty if x1 < x0 or y1 < y0
+ */
+static void world_get_visible_cells(float cell_size, Sint32 columns, Sint32 rows, Sint32 *x0, Sint32 *y0, Sint32 *x1, Sint32 *y1) {
+	GFC_Rect view = main_camera_get_view();
+	*x0 = MAX((Sint32)floor(view.x / cell_size), 0);
+	*y0 = MAX((Sint32)floor(view.y / cell_size), 0);
+	*x1 = MIN((Sint32)floor((view.x + view.w) / cell_size), columns - 1);
+	*y1 = MIN((Sint32)floor((view.y + view.h) / cell_size), rows - 1);
+}
+
+/**
+ * @brief queue the tile layer chunks that intersect the camera's view, baking any that are missing
+ * @param world the world being drawn
+ */
+static void world_draw_tile_chunks(World *world) {
+	Sint32 cx, cy, cx0, cy0, cx1, cy1, columns, rows;
+	GFC_Vector2D scale, draw_pos;
+	Sprite *chunk;
+
+	if (!world->chunk_size || !world->tile_set) return;
+	world->chunk_frame++;
+
+	columns = ((Uint32)world->world_size.x * world->tile_size + world->chunk_size - 1) / world->chunk_size;
+	rows = ((Uint32)world->world_size.y * world->tile_size + world->chunk_size - 1) / world->chunk_size;
+	world_get_visible_cells(world->chunk_size, columns, rows, &cx0, &cy0, &cx1, &cy1);
+
+	scale = main_camera_get_zoom();
+	for (cy = cy0; cy <= cy1; cy++) {
+		for (cx = cx0; cx <= cx1; cx++) {
+			chunk = world_get_tile_chunk(world, cx, cy);
+			if (!chunk) continue;
+			draw_pos = main_camera_calc_drawpos(gfc_vector2d(cx * world->chunk_size, cy * world->chunk_size));
+			gf2d_render_queue_sprite(chunk,
+					draw_pos,
+					&scale,
+					NULL,
+					NULL,
+					NULL,
+					NULL,
+					NULL,
+					0,
+					RL_TILES,
+					0);
+		}
+	}
+	world_trim_tile_chunks(world);
+}
+
+/**
+ * @brief queue a quad from the tile set for every visible tile, nothing is baked
+ * @param world the world being drawn
+ * @note every quad shares the tile set's texture and render key, so they all end up in one batch
+ */
+static void world_draw_tiles_dynamic(World *world) {
+	Sint32 x, y, x0, y0, x1, y1;
+	GFC_Vector2D scale, draw_pos;
+	Uint32 id, now = SDL_GetTicks();
+
+	if (!world->tile_set || !world->tile_size) return;
+	world_get_visible_cells(world->tile_size, world->world_size.x, world->world_size.y, &x0, &y0, &x1, &y1);
+
+	scale = main_camera_get_zoom();
+	for (y = y0; y <= y1; y++) {
+		for (x = x0; x <= x1; x++) {
+			id = world->tile_map[y * (Sint32)world->world_size.x + x];
+			if (!id) continue;
+			draw_pos = main_camera_calc_drawpos(gfc_vector2d(x * world->tile_size, y * world->tile_size));
+			gf2d_render_queue_sprite(world->tile_set,
+					draw_pos,
+					&scale,
+					NULL,
+					NULL,
+					NULL,
+					NULL,
+					NULL,
+					world_get_tile_frame(world, id, now),
+					RL_TILES,
+					0);
+		}
+	}
+}
+
+/**
+ * @brief queue the visible animated tiles over the baked chunks
+ * @param world the world being drawn
+ * @note each visible row is found in the sorted animated tile list with a binary search,
+ *       so only animated tiles that are on screen are visited
+ */
+static void world_draw_animated_tiles(World *world) {
+	Sint32 y, x0, y0, x1, y1;
+	Uint32 i, index, row_end, width, now;
+	GFC_Vector2D scale, draw_pos;
+
+	if (!world->animated_count || !world->tile_set || !world->tile_size) return;
+	width = world->world_size.x;
+	world_get_visible_cells(world->tile_size, world->world_size.x, world->world_size.y, &x0, &y0, &x1, &y1);
+	if (x1 < x0) return;
+
+	now = SDL_GetTicks();
+	scale = main_camera_get_zoom();
+	for (y = y0; y <= y1; y++) {
+		row_end = y * width + x1;
+		for (i = world_find_animated_tile(world, y * width + x0); i < world->animated_count; i++) {
+			index = world->animated_tiles[i];
+			if (index > row_end) break;
+			draw_pos = main_camera_calc_drawpos(gfc_vector2d((index % width) * world->tile_size, y * world->tile_size));
+			gf2d_render_queue_sprite(world->tile_set,
+					draw_pos,
+					&scale,
+					NULL,
+					NULL,
+					NULL,
+					NULL,
+					NULL,
+					world_get_tile_frame(world, world->tile_map[index], now),
+					RL_TILES,
+					1);
+		}
+	}
+}
+
+Uint8 world_set_tile(World *world, Uint32 x, Uint32 y, Uint32 id) {
+	Uint32 index;
+	if (!world || !world->tile_map) return 0;
+	if (x >= (Uint32)world->world_size.x || y >= (Uint32)world->world_size.y) {
+		slog("cannot set tile (%i, %i) outside of the world", x, y);
+		return 0;
+	}
+	if (id > world->tile_count) {
+		slog("cannot set tile (%i, %i) to unknown tile id %i", x, y, id);
+		return 0;
+	}
+
+	index = y * (Uint32)world->world_size.x + x;
+	if (world->tile_map[index] == id) return 0;
+	if (world_tile_is_animated(world, world->tile_map[index])) world_remove_animated_tile(world, index);
+	if (world_tile_is_animated(world, id)) world_add_animated_tile(world, index);
+	world->tile_map[index] = id;
 
-	// Set frame_w and frame_h for ease of access
-	world->tile_layer->frame_w = world->world_size.x * world->tile_size;
-	world->tile_layer->frame_h = world->world_size.y * world->tile_size;
+	// The space reads the tile map directly, it only needs to wake what was touching the cell
+	space_tile_changed(world->space, x, y);
+	world_mark_tile_dirty(world, x, y);
+	return 1;
 }
 
 /**
@@ -178,30 +578,110 @@ void world_build_space(World *world) {
 	// Verify the pointer
 	if (!world || !world->tile_map || !world->tile_data) return;
 
-	// Variables
-	int i, c;
-
-	// Create the space
+	// Create the space and give it the tile grid, tiles are collided straight from the grid
+	// so they are not added as static shapes
 	world->space = space_new();
+	if (!world->space) return;
+	space_set_tile_grid(
+		world->space,
+		world->tile_map,
+		world->tile_data,
+		world->tile_count,
+		world->world_size.x,
+		world->world_size.y,
+		world->tile_size);
+}
 
-	// Add static shapes to the world
-	c = world->world_size.x * world->world_size.y;
-	for (i = 0; i < c; i++) {
-		if (world->tile_map[i] != 0 && world->tile_data[world->tile_map[i] - 1].collision_type != TCT_NONE) {
-			// Get the tiledata to get info about the tile's bounding box
-			TileData dat = world->tile_data[world->tile_map[i] - 1];
-			
-			// Compute the tile's position in space
-			int y_pos = (i / (int)world->world_size.x) * world->tile_size;
-			int x_pos = (i % (int)world->world_size.x) * world->tile_size;
-
-			// Create the static shape for the tile's bounding box
-			GFC_Rect rect = gfc_rect((float)x_pos, (float)y_pos, dat.collision_box.x, dat.collision_box.y);
-			
-			// Add the static shape
-			space_add_static_shape(world->space, gfc_shape_from_rect(rect));
+/**
+ * @brief add a parallax layer to a world
+ * @param world the world being loaded
+ * @param image the path to the layer's image
+ * @param scroll_factor how far the layer moves relative to the camera
+ * @param repeat which directions the image repeats in
+ * @param offset (optional) where the image's top left corner sits, if NULL the image is centered on the screen
+ * @return NULL if the world is out of layers or the image failed to load, otherwise the layer
+ */
+static ParallaxLayer *world_add_parallax(World *world, const char *image, float scroll_factor, ParallaxRepeat repeat, GFC_Vector2D *offset) {
+	ParallaxLayer *layer;
+	if (world->parallax_count >= WORLD_MAX_PARALLAX_LAYERS) {
+		slog("world already has %i parallax layers, skipping %s", WORLD_MAX_PARALLAX_LAYERS, image);
+		return NULL;
+	}
+	layer = &world->parallax[world->parallax_count];
+	memset(layer, 0, sizeof(ParallaxLayer));
+	layer->sprite = gf2d_sprite_load_image(image);
+	if (!layer->sprite) return NULL;
+	layer->scroll_factor = scroll_factor;
+	layer->repeat = repeat;
+	if (offset) layer->offset = *offset;
+	else layer->offset = gfc_vector2d(layer->sprite->frame_w * -0.5, layer->sprite->frame_h * -0.5);
+	world->parallax_count++;
+	return layer;
+}
+
+/**
+ * @brief load a world's parallax layers from its def
+ * @param world the world being loaded
+ * @param world_json the world's def object
+ * @return 0 if the def has no layers
+ * @note "parallaxLayers" is an array of {"image", "scrollFactor", "repeat", "offset", "inFront"} objects, inFront is 0 or 1,
+ *       repeat is one of "none", "x", "y" or "both". Defs without it use "background" and "foreground" scrolled
+ *       by "parallaxFactor" and twice that, as they always have
+ */
+static Uint8 world_load_parallax(World *world, SJson *world_json) {
+	SJson *layers, *item;
+	ParallaxLayer *layer;
+	ParallaxRepeat repeat;
+	GFC_Vector2D offset;
+	const char *image, *repeat_name;
+	float scroll_factor;
+	int i, c, in_front;
+
+	layers = sj_object_get_value(world_json, "parallaxLayers");
+	if (layers) {
+		c = sj_array_get_count(layers);
+		for (i = 0; i < c; i++) {
+			item = sj_array_get_nth(layers, i);
+			image = sj_object_get_string(item, "image");
+			if (!image) {
+				slog("parallax layer %i is missing its 'image' path", i);
+				continue;
+			}
+			scroll_factor = 1;
+			sj_object_get_float(item, "scrollFactor", &scroll_factor);
+			repeat = PR_NONE;
+			repeat_name = sj_object_get_string(item, "repeat");
+			if (repeat_name) {
+				if (strcmp(repeat_name, "x") == 0) repeat = PR_X;
+				else if (strcmp(repeat_name, "y") == 0) repeat = PR_Y;
+				else if (strcmp(repeat_name, "both") == 0) repeat = PR_BOTH;
+				else if (strcmp(repeat_name, "none") != 0) slog("unknown parallax repeat %s, drawing once", repeat_name);
+			}
+			layer = world_add_parallax(world, image, scroll_factor, repeat,
+					sj_object_get_vector2d(item, "offset", &offset) ? &offset : NULL);
+			in_front = 0;
+			sj_object_get_int(item, "inFront", &in_front);
+			if (layer) layer->in_front = in_front;
 		}
+		return 1;
+	}
+
+	// Older defs have exactly one background and one foreground
+	const char * background = sj_object_get_string(world_json, "background");
+	if (!background) {
+		slog("missing 'parallaxLayers' or 'background' path");
+		return 0;
+	}
+	const char * foreground = sj_object_get_string(world_json, "foreground");
+	if (!foreground) {
+		slog("missing 'foreground' path");
+		return 0;
 	}
+	scroll_factor = 0;
+	sj_object_get_float(world_json, "parallaxFactor", &scroll_factor);
+	world_add_parallax(world, background, scroll_factor, PR_NONE, NULL);
+	world_add_parallax(world, foreground, scroll_factor * 2.0, PR_NONE, NULL);
+	return 1;
 }
 
 /**
@@ -257,24 +737,8 @@ World *world_load(const char *filename) {
 		return NULL;
 	}
 
-	// Load the background
-	const char * background = sj_object_get_string(world_json, "background");
-	if (!background) {
-		slog("missing 'background' path");
-		return NULL;
-	}
-	world->background = gf2d_sprite_load_image(background);
-	
-	// Load the foreground
-	const char * foreground = sj_object_get_string(world_json, "foreground");
-	if (!foreground) {
-		slog("missing 'foreground' path");
-		return NULL;
-	}
-	world->foreground = gf2d_sprite_load_image(foreground);
-
-	// Get the parallax scale factor
-	sj_object_get_float(world_json, "parallaxFactor", &world->bg_factor);
+	// Load the parallax layers, or the older single background and foreground
+	if (!world_load_parallax(world, world_json)) return NULL;
 
 	// Load the tileset
 	const char * tileset = sj_object_get_string(world_json, "tileSet");
@@ -294,6 +758,11 @@ World *world_load(const char *filename) {
 		1);
 
 	world->tile_size = tileset_framesize;
+
+	// Small maps bake their tiles, large or often edited maps can draw them straight from the tile set
+	const char *render_mode = sj_object_get_string(world_json, "tileRenderMode");
+	if (render_mode && strcmp(render_mode, "dynamic") == 0) world->render_mode = TRM_DYNAMIC;
+	else if (render_mode && strcmp(render_mode, "baked") != 0) slog("unknown 'tileRenderMode' %s, baking tiles", render_mode);
 	
 	// Load the tiledata
 	int i;
@@ -309,6 +778,25 @@ World *world_load(const char *filename) {
 		sj_object_get_int(tile, "collisionType", &coll_type);
 		sj_object_get_uint32(tile, "frame", &frame);
 		
+		// Load the tile's animation, if it has one
+		SJson *animation = sj_object_get_value(tile, "animation");
+		if (animation) {
+			SJson *frames = sj_object_get_value(animation, "frames");
+			int f, frame_count = sj_array_get_count(frames);
+			if (frame_count > TILE_ANIM_MAX_FRAMES) {
+				slog("tile %i has %i animation frames, only the first %i are used", i, frame_count, TILE_ANIM_MAX_FRAMES);
+				frame_count = TILE_ANIM_MAX_FRAMES;
+			}
+			for (f = 0; f < frame_count; f++) {
+				int anim_frame = 0;
+				sj_get_integer_value(sj_array_get_nth(frames, f), &anim_frame);
+				world->tile_data[i].anim_frames[f] = anim_frame;
+			}
+			world->tile_data[i].anim_frame_count = MAX(frame_count, 0);
+			world->tile_data[i].anim_frame_duration = 100;
+			sj_object_get_uint32(animation, "frameDuration", &world->tile_data[i].anim_frame_duration);
+		}
+
 		// Load tile data into slot
 		world->tile_data[i].frame = frame;
 		world->tile_data[i].collision_type = (TileCollisionType)coll_type;
@@ -359,74 +847,110 @@ World *world_load(const char *filename) {
 	return world;
 }
 
+/**
+ * @brief get the range of image copies, and the cells within them, a parallax layer has on screen along one axis
+ * @param view_start the start of the view in layer space
+ * @param view_size the size of the view in layer space
+ * @param offset where the first copy of the image starts
+ * @param size the size of the image
+ * @param repeat if the image repeats along this axis
+ * @param first set to the first visible copy
+ * @param last set to the last visible copy, less than first if none are visible
+ */
+static void world_get_parallax_copies(float view_start, float view_size, float offset, float size, Uint8 repeat, Sint32 *first, Sint32 *last) {
+	if (!repeat) {
+		*first = 0;
+		*last = (offset < view_start + view_size && offset + size > view_start) ? 0 : -1;
+		return;
+	}
+	*first = (Sint32)floor((view_start - offset) / size);
+	*last = (Sint32)floor((view_start + view_size - offset) / size);
+}
+
+/**
+ * @brief queue the on screen cells of a parallax layer
+ * @param layer the layer to draw
+ * @param index the layer's place in the world's list, used as its depth
+ * @note every cell is the same texture and render key, so a layer batches into a single draw
+ */
+static void world_draw_parallax(ParallaxLayer *layer, Uint32 index) {
+	Sint32 copy_x, copy_y, first_x, first_y, last_x, last_y;
+	Sint32 cell_x, cell_y, cells_x, cells_y, cx0, cy0, cx1, cy1;
+	GFC_Vector2D scale, half, camera, view_start, view_size, image_pos, draw_pos;
+	GFC_Vector4D clip;
+	float w, h;
+
+	if (!layer->sprite || !layer->sprite->frame_w || !layer->sprite->frame_h) return;
+	w = layer->sprite->frame_w;
+	h = layer->sprite->frame_h;
+
+	// The layer sits at offset + copy * size in its own space, which is shifted by the camera times the scroll factor
+	scale = main_camera_get_zoom();
+	half = gf2d_graphics_get_resolution();
+	gfc_vector2d_scale_by(half, half, gfc_vector2d(0.5, 0.5));
+	camera = camera_get_main()->position;
+	view_size = gfc_vector2d(half.x * 2 / scale.x, half.y * 2 / scale.y);
+	view_start = gfc_vector2d(camera.x * layer->scroll_factor - half.x / scale.x, camera.y * layer->scroll_factor - half.y / scale.y);
+
+	world_get_parallax_copies(view_start.x, view_size.x, layer->offset.x, w, layer->repeat & PR_X, &first_x, &last_x);
+	world_get_parallax_copies(view_start.y, view_size.y, layer->offset.y, h, layer->repeat & PR_Y, &first_y, &last_y);
+	cells_x = (w + WORLD_PARALLAX_CELL - 1) / WORLD_PARALLAX_CELL;
+	cells_y = (h + WORLD_PARALLAX_CELL - 1) / WORLD_PARALLAX_CELL;
+
+	for (copy_y = first_y; copy_y <= last_y; copy_y++) {
+		for (copy_x = first_x; copy_x <= last_x; copy_x++) {
+			image_pos = gfc_vector2d(layer->offset.x + copy_x * w, layer->offset.y + copy_y * h);
+			draw_pos = gfc_vector2d(
+				half.x + (image_pos.x - camera.x * layer->scroll_factor) * scale.x,
+				half.y + (image_pos.y - camera.y * layer->scroll_factor) * scale.y);
+
+			// Only the cells of this copy under the view
+			cx0 = MAX((Sint32)floor((view_start.x - image_pos.x) / WORLD_PARALLAX_CELL), 0);
+			cy0 = MAX((Sint32)floor((view_start.y - image_pos.y) / WORLD_PARALLAX_CELL), 0);
+			cx1 = MIN((Sint32)floor((view_start.x + view_size.x - image_pos.x) / WORLD_PARALLAX_CELL), cells_x - 1);
+			cy1 = MIN((Sint32)floor((view_start.y + view_size.y - image_pos.y) / WORLD_PARALLAX_CELL), cells_y - 1);
+			for (cell_y = cy0; cell_y <= cy1; cell_y++) {
+				for (cell_x = cx0; cell_x <= cx1; cell_x++) {
+					clip = gfc_vector4d(
+						cell_x * WORLD_PARALLAX_CELL / w,
+						cell_y * WORLD_PARALLAX_CELL / h,
+						MIN((cell_x + 1) * WORLD_PARALLAX_CELL / w, 1),
+						MIN((cell_y + 1) * WORLD_PARALLAX_CELL / h, 1));
+					gf2d_render_queue_sprite(layer->sprite,
+							draw_pos,
+							&scale,
+							NULL,
+							NULL,
+							NULL,
+							NULL,
+							&clip,
+							0,
+							layer->in_front ? RL_FOREGROUND : RL_BACKGROUND,
+							index);
+				}
+			}
+		}
+	}
+}
+
 /**
  * @brief draws the world's tilemap
  * @param world the world object to be drawn
  */
 void world_draw(World *world) {
-	// Get the camera object
-	Camera* camera = camera_get_main();
-
-	// Calculate scale
-	GFC_Vector2D scale = main_camera_get_zoom(camera);
-
-	// Get centers
-	GFC_Vector2D bg_center = gfc_vector2d(world->background->frame_w * 0.5, world->background->frame_h * 0.5);
-	GFC_Vector2D fg_center = gfc_vector2d(world->foreground->frame_w * 0.5, world->foreground->frame_h * 0.5);
-
-	// Get half the screen res for repositioning
-	GFC_Vector2D screen_res_offset = gf2d_graphics_get_resolution();
-	gfc_vector2d_scale_by(screen_res_offset, screen_res_offset, gfc_vector2d(0.5, 0.5));
-
-	// Calculate draw position of the background
-	GFC_Vector2D bg_pos_scale = gfc_vector2d(scale.x * world->bg_factor, scale.y * world->bg_factor);
-	GFC_Vector2D bg_draw_pos = {0};
-	gfc_vector2d_add(bg_draw_pos, bg_draw_pos, main_camera_get_offset());
-	gfc_vector2d_scale_by(bg_draw_pos, bg_draw_pos, bg_pos_scale);
-	gfc_vector2d_add(bg_draw_pos, bg_draw_pos, screen_res_offset);
-	
-	// Calculate draw position of the foreground
-	GFC_Vector2D fg_pos_scale = gfc_vector2d(scale.x * 2.0 * world->bg_factor, scale.y * 2.0 * world->bg_factor);
-	GFC_Vector2D fg_draw_pos = {0};
-	gfc_vector2d_add(fg_draw_pos, fg_draw_pos, main_camera_get_offset());
-	gfc_vector2d_scale_by(fg_draw_pos, fg_draw_pos, fg_pos_scale);
-	gfc_vector2d_add(fg_draw_pos, fg_draw_pos, screen_res_offset);
-
-	// Draw the background and foreground
-	gf2d_sprite_draw(world->background,
-			bg_draw_pos,
-			&scale,
-			&bg_center,
-			NULL,
-			NULL,
-			NULL,
-			0);
-
-	gf2d_sprite_draw(world->foreground,
-			fg_draw_pos,
-			&scale,
-			&fg_center,
-			NULL,
-			NULL,
-			NULL,
-			0);
-	
-	// For drawing the tiles themselves we will not change the center
-	// (0,0) is where the player spawns right now, as well as the top left bound of the map
-	GFC_Vector2D tile_layer_draw_pos = {0};
-	gfc_vector2d_add(tile_layer_draw_pos, tile_layer_draw_pos, main_camera_get_offset());
-	gfc_vector2d_scale_by(tile_layer_draw_pos, tile_layer_draw_pos, scale);
-	gfc_vector2d_add(tile_layer_draw_pos, tile_layer_draw_pos, screen_res_offset);
-
-	gf2d_sprite_draw(world->tile_layer,
-			tile_layer_draw_pos,
-			&scale,
-			NULL,
-			NULL,
-			NULL,
-			NULL,
-			0);
+	Uint32 layer;
+
+	// Queue the parallax layers, each one sorts just above the one before it
+	for (layer = 0; layer < world->parallax_count; layer++) {
+		world_draw_parallax(&world->parallax[layer], layer);
+	}
 
+	// Queue the tiles in view, (0,0) is the top left corner of the map
+	if (world->render_mode == TRM_DYNAMIC) world_draw_tiles_dynamic(world);
+	else {
+		world_draw_tile_chunks(world);
+		world_draw_animated_tiles(world);
+	}
 
 	// Draw the world's space
 	space_draw(world->space);